@@ -30,8 +30,8 @@ fi
 
 cd ./src
 make clean
-make visualize_tweets_finitefile || { echo 'Compilation failed' ; exit 1; }
-mv visualize_tweets_finitefile ..
+make visualize_tweets_finitefile convert_bdnet || { echo 'Compilation failed' ; exit 1; }
+mv visualize_tweets_finitefile convert_bdnet ..
 cd ..
 
 echo "========================================================================="
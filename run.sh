@@ -19,18 +19,18 @@ function print_description {
 }
 
 function get_shared_opts {
-   if [ ! -f data/$net.wdnet ]; then
-      gunzip -c data/$net.wdnet.gz > data/$net.wdnet;
+   if [ ! -f data/$net.bdnet ]; then
+      local text=data/$net.wdnet
+      if [ ! -f $text ]; then text=data/$net.wdnet.gz; fi
+      ./convert_bdnet --inputformat weighted --input $text \
+         --output data/$net.bdnet > /dev/null
    fi
-   local shared_opts="--verbose 2 --inputformat weighted --input data/$net.wdnet"
+   local shared_opts="--verbose 2 --input data/$net.bdnet"
    shared_opts+=" --timecontraction $vtc --edgemin $edgemin"
    echo $shared_opts
 }
 
 function get_label1 {
-   if [ ! -f data/$net.wdnet ]; then
-      gunzip -c data/$net.wdnet.gz > data/$net.wdnet;
-   fi
    local label=""
    if [ "$net" == "osama" ]; then label="death of"; fi
    if [ "$net" == "superbowl" ]; then label="hashtags during the"; fi
@@ -40,9 +40,6 @@ function get_label1 {
 }
 
 function get_label2 {
-   if [ ! -f data/$net.wdnet ]; then
-      gunzip -c data/$net.wdnet.gz > data/$net.wdnet;
-   fi
    local label=""
    if [ "$net" == "osama" ]; then label="Osama bin Laden"; fi
    if [ "$net" == "superbowl" ]; then label="#superbowl"; fi
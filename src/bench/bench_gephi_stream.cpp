@@ -0,0 +1,208 @@
+/*
+ * Benchmark of sending frames of events to a local stub of the Gephi
+ * Streaming API server: each frame posted on a new connection as it was
+ * done before, against the frames streamed as chunks over a connection
+ * kept open, one or a batch of them per request; measures the sustained
+ * events per second with the server answering and accepting connections
+ * after a round trip of 1 ms, as over a local network, and checks that no
+ * frame is lost when the server breaks the connection in the middle of
+ * some requests
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <util/http_stream.hpp>
+
+using namespace std;
+
+static const unsigned roundtrip = 1000; // microseconds
+
+// reads the requests of the connections one after the other, counts their
+// events and the frames seen, answers each request with 200 after the
+// round trip unless it breaks the connection in the middle of every
+// breakevery-th request
+class stub_server {
+public:
+   stub_server(unsigned frames) : breakevery(0), requests(0), events(0),
+         seen(frames, false) {
+      listener = socket(AF_INET, SOCK_STREAM, 0);
+      sockaddr_in a = sockaddr_in();
+      a.sin_family = AF_INET;
+      a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      bind(listener, (sockaddr*)&a, sizeof(a));
+      listen(listener, 16);
+      socklen_t len = sizeof(a);
+      getsockname(listener, (sockaddr*)&a, &len);
+      port = ntohs(a.sin_port);
+      server = thread(&stub_server::serve, this);
+   }
+   ~stub_server() {
+      shutdown(listener, SHUT_RDWR);
+      server.join();
+      close(listener);
+   }
+
+   unsigned port;
+   atomic <unsigned> breakevery;
+   atomic <unsigned long> requests, events;
+   vector <bool> seen; // read after the client has finished
+
+   unsigned frames_seen() const {
+      unsigned n = 0;
+      for (size_t f=0; f<seen.size(); f++) n += seen[f];
+      return n;
+   }
+
+private:
+   int listener, fd;
+   string input;
+   thread server;
+
+   void serve() {
+      while ((fd = accept(listener, 0, 0))>=0) {
+         this_thread::sleep_for(chrono::microseconds(roundtrip));
+         input.clear();
+         while (request()) { }
+         close(fd);
+      }
+   }
+
+   bool request() {
+      string line;
+      bool chunked = false;
+      long length = 0;
+      do {
+         if (!read_line(line)) return false;
+         if (line.compare(0, 26, "Transfer-Encoding: chunked")==0)
+            chunked = true;
+         if (line.compare(0, 15, "Content-Length:")==0)
+            length = atol(line.c_str()+15);
+      } while (!line.empty());
+      unsigned long r = ++requests;
+      bool breaks = breakevery>0 && r%breakevery==0;
+
+      string body;
+      while (chunked) {
+         if (!read_line(line)) return false;
+         size_t size = strtoul(line.c_str(), 0, 16);
+         if (size==0) {
+            read_line(line);
+            break;
+         }
+         if (!read(size+2, body)) return false;
+         body.resize(body.size()-2);
+         // the connection breaks after the first chunk
+         if (breaks) return false;
+      }
+      if (!chunked && !read(length, body)) return false;
+
+      for (size_t start=0, end; (end = body.find('\r', start))!=string::npos;
+            start = end+1) {
+         events++;
+         size_t frame = body.find("\"frame ", start);
+         if (frame<end) {
+            unsigned f = atoi(body.c_str()+frame+7);
+            if (f<seen.size()) seen[f] = true;
+         }
+      }
+      this_thread::sleep_for(chrono::microseconds(roundtrip));
+      const char answer[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+      return ::send(fd, answer, sizeof(answer)-1, MSG_NOSIGNAL)>0;
+   }
+
+   bool more() {
+      char buffer[1<<16];
+      ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+      if (got<=0) return false;
+      input.append(buffer, got);
+      return true;
+   }
+
+   bool read_line(string &line) {
+      size_t end;
+      while ((end = input.find("\r\n"))==string::npos)
+         if (!more()) return false;
+      line.assign(input, 0, end);
+      input.erase(0, end+2);
+      return true;
+   }
+
+   bool read(size_t len, string &out) {
+      while (input.size()<len)
+         if (!more()) return false;
+      out.append(input, 0, len);
+      input.erase(0, len);
+      return true;
+   }
+};
+
+// a frame of events as the visualization sends them, starting with the
+// label of the frame
+static string make_frame(unsigned f, unsigned events) {
+   char event[160];
+   string frame;
+   frame.append(event, sprintf(event,
+      "{\"cl\":{\"datetime\":{\"label\":\"frame %u\"}}}\r", f));
+   for (unsigned e=1; e<events; e++)
+      frame.append(event, sprintf(event,
+         "{\"cn\":{\"@user_%u\":{\"b\":0.8,\"g\":0.2,\"r\":0,"
+         "\"size\":%.17g}}}\r", (f*events+e)%10007, 5*sqrt(1.0+e%97)));
+   return frame;
+}
+
+int main(int argc, char** argv) {
+   const unsigned frames = 2000, events = 100;
+   vector <string> all;
+   for (unsigned f=0; f<frames; f++) all.push_back(make_frame(f, events));
+
+   const char *methods[] = {"post each frame", "stream, batch 1",
+      "stream, batch 30", "stream, batch 30, broken every 7th request"};
+   bool complete = true;
+   for (unsigned method=0; method<4; method++) {
+      stub_server stub(frames);
+      if (method==3) stub.breakevery = 7;
+      char url[64];
+      sprintf(url, "http://127.0.0.1:%u/workspace0?operation=updateGraph",
+         stub.port);
+
+      unsigned long connections = 0, resent = 0;
+      auto start = chrono::steady_clock::now();
+      if (method==0) {
+         // a new connection and a request for each frame
+         for (unsigned f=0; f<frames; f++) {
+            http_stream post(url, 1, 0, 10);
+            post.send(all[f]);
+            connections += post.get_connections();
+         }
+      }
+      else {
+         http_stream stream(url, method==1 ? 1 : 30, 0, 10);
+         for (unsigned f=0; f<frames; f++) stream.send(all[f]);
+         stream.flush();
+         connections = stream.get_connections();
+         resent = stream.get_resent();
+      }
+      double elapsed = chrono::duration<double>(
+         chrono::steady_clock::now()-start).count();
+
+      unsigned seen = stub.frames_seen();
+      complete = complete && seen==frames;
+      printf("%-44s events/s=%9.0f connections=%5lu requests=%5lu "
+         "frames sent again=%4lu frames received=%u/%u\n", methods[method],
+         frames*events/elapsed, connections, (unsigned long)stub.requests,
+         resent, seen, frames);
+   }
+   printf("all frames received: %s\n", complete ? "yes" : "NO");
+   return complete ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+/*
+ * Benchmark of writing the events of each type sent to the output client,
+ * building a Json::Value for each event and writing it with
+ * Json::FastWriter as it was done before against the client writing them
+ * directly; checks also that both give the same bytes, for the events of
+ * the tool and for names with any bytes in them, and counts the heap
+ * allocations made for each event; the events written in the binary
+ * format bdframes are timed as well, with their size
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <json/json.h>
+
+#include <viz/client.hpp>
+
+using namespace std;
+
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+   allocations++;
+   void *p = malloc(size);
+   if (!p) throw bad_alloc();
+   return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+// keeps the events of the frame in memory
+class client_memory : public client_base {
+public:
+   void update() { }
+   void send_chunk() { }
+   string& events() { return task; }
+};
+
+// keeps the events of the frame in memory in the binary format
+class client_memory_binary : public client_memory {
+protected:
+   void write_event(const char *type, const event_id &id,
+         const event_attribute *const *attributes, unsigned n) {
+      frames.event(events(), type, id, attributes, n);
+   }
+private:
+   bdframes_writer frames;
+};
+
+// the events as they were written before
+class json_value_writer {
+public:
+   template <class TT1>
+   void set_attributes(string a1, TT1 v1) {
+      attributes.clear();
+      attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
+   }
+   template <class TT1, class TT2, class TT3, class TT4>
+   void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
+         string a4, TT4 v4) {
+      set_attributes(a1, v1);
+      attributes.push_back(pair<string, string>(a2,lexical_cast<string>(v2)));
+      attributes.push_back(pair<string, string>(a3,lexical_cast<string>(v3)));
+      attributes.push_back(pair<string, string>(a4,lexical_cast<string>(v4)));
+   }
+   template <class TT1, class TT2, class TT3, class TT4, class TT5, class TT6,
+         class TT7>
+   void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
+         string a4, TT4 v4, string a5, TT5 v5, string a6, TT6 v6,
+         string a7, TT7 v7) {
+      set_attributes(a1, v1, a2, v2, a3, v3, a4, v4);
+      attributes.push_back(pair<string, string>(a5,lexical_cast<string>(v5)));
+      attributes.push_back(pair<string, string>(a6,lexical_cast<string>(v6)));
+      attributes.push_back(pair<string, string>(a7,lexical_cast<string>(v7)));
+   }
+
+   template <class TT0> void add_node(TT0 id) {produce_event("an", id);}
+   template <class TT0> void change_node(TT0 id) {produce_event("cn", id);}
+   template <class TT0> void delete_node(TT0 id)
+   {produce_event_no_attributes("dn", id);}
+   template <class TT0> void add_edge(TT0 id) {produce_event("ae", id);}
+   template <class TT0> void change_edge(TT0 id) {produce_event("ce", id);}
+   template <class TT0> void change_label(TT0 id) {produce_event("cl", id);}
+
+   string task;
+
+private:
+   template <class TT0>
+   void produce_event(string type, TT0 id) {
+      Json::Value jsonroot;
+      jsonroot[type][lexical_cast<string>(id)]=Json::Value(Json::objectValue);
+      for (vector <pair <string, string> >:: iterator it=attributes.begin();
+            it!=attributes.end(); it++)
+         jsonroot[type][lexical_cast<string>(id)][(*it).first]=(*it).second;
+      task+=jsonwriter.write(jsonroot);
+      *task.rbegin()='\r';
+   }
+
+   template <class TT0>
+   void produce_event_no_attributes(string type, TT0 id) {
+      Json::Value jsonroot;
+      jsonroot[type][id]=Json::Value(Json::objectValue);
+      task+=jsonwriter.write(jsonroot);
+      *task.rbegin()='\r';
+   }
+
+   vector <pair <string, string> > attributes;
+   Json::FastWriter jsonwriter;
+};
+
+static const char* event_types[] = {"an", "cn", "ae", "ce", "dn", "cl"};
+
+// the event of the type, with the attributes the visualization gives it
+template <class W>
+static void add_event(W &w, unsigned type, const vector <string> &names,
+      unsigned long i) {
+   const char *name = names[i%names.size()].c_str();
+   const char *other = names[(i*7+3)%names.size()].c_str();
+   double weight = 0.5+(i%1000)/7.0;
+   switch (type) {
+   case 0:
+      w.set_attributes("r",1, "g",1, "b",0, "label",name);
+      w.add_node(name);
+      break;
+   case 1:
+      w.set_attributes("r",0.0, "g",0.2, "b",0.8, "size",5*sqrt(weight));
+      w.change_node(name);
+      break;
+   case 2:
+      w.set_attributes("source",name, "target",other, "directed",false,
+         "weight",weight, "r",0.4, "g",0.6, "b",0.8);
+      w.add_edge(i+1);
+      break;
+   case 3:
+      w.set_attributes("weight",weight, "r",0.4, "g",0.6, "b",0.8);
+      w.change_edge(i+1);
+      break;
+   case 4:
+      w.delete_node(name);
+      break;
+   case 5:
+      w.set_attributes("label","2011-May-02 03:30:00");
+      w.change_label("datetime");
+      break;
+   }
+}
+
+int main(int argc, char** argv) {
+   // names as the tool reads them, and names with any bytes
+   vector <string> names, anybytes;
+   for (unsigned i=0; i<10000; i++)
+      names.push_back((i%2 ? "#tag" : "@user_")+lexical_cast<string>(i));
+   srand(1);
+   for (unsigned i=0; i<100000; i++) {
+      string name(1+rand()%12, ' ');
+      for (unsigned k=0; k<name.size(); k++) name[k] = 1+rand()%255;
+      anybytes.push_back(name);
+   }
+
+   const unsigned events = 200000;
+   bool same = true;
+   for (unsigned type=0; type<sizeof(event_types)/sizeof(event_types[0]);
+         type++) {
+      json_value_writer old;
+      client_memory client;
+      client_memory_binary binary;
+      double elapsed[3], allocated[3], bytes[3] = {0, 0, 0};
+      for (unsigned method=0; method<3; method++) {
+         unsigned long before = allocations;
+         auto start = chrono::steady_clock::now();
+         for (unsigned long i=0; i<events; i++) {
+            if (method==0) add_event(old, type, names, i);
+            else if (method==1) add_event(client, type, names, i);
+            else add_event(binary, type, names, i);
+            // the events are sent a frame at a time
+            if (i%1000==999) {
+               bytes[method] += old.task.size()+client.events().size()
+                  +binary.events().size();
+               old.task.clear();
+               client.events().clear();
+               binary.events().clear();
+            }
+         }
+         elapsed[method] = chrono::duration<double>(
+            chrono::steady_clock::now()-start).count();
+         allocated[method] = allocations-before;
+      }
+      printf("event %s nsec/event: Json::Value=%7.1f direct=%7.1f "
+         "bdframes=%6.1f allocations/event: Json::Value=%5.2f direct=%5.2f "
+         "bytes/event: JSON=%5.1f bdframes=%4.1f\n",
+         event_types[type], 1e9*elapsed[0]/events, 1e9*elapsed[1]/events,
+         1e9*elapsed[2]/events, allocated[0]/events, allocated[1]/events,
+         bytes[1]/events, bytes[2]/events);
+
+      const vector <string> *tested[] = {&names, &anybytes};
+      for (unsigned t=0; t<2; t++) {
+         old.task.clear();
+         client.events().clear();
+         for (unsigned long i=0; i<tested[t]->size(); i++) {
+            add_event(old, type, *tested[t], i);
+            add_event(client, type, *tested[t], i);
+         }
+         same = same && old.task==client.events();
+      }
+   }
+   printf("same bytes: %s\n", same ? "yes" : "NO");
+   return same ? 0 : 1;
+}
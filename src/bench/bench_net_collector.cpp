@@ -0,0 +1,80 @@
+/*
+ * Benchmark of the cost of adding a linkpack to the fastviz collector
+ * in the steady state, when every new node evicts the weakest stored one
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <pms/clock_collector.hpp>
+#include <util/name_table.hpp>
+#include <viz/net_collector.hpp>
+
+using namespace std;
+
+// node names drawn from a vocabulary with a heavy-tailed popularity
+class linkpack_generator {
+public:
+   linkpack_generator(unsigned vocabulary, name_table &nodenames,
+         unsigned seed=1) {
+      srand(seed);
+      for (unsigned i=0; i<vocabulary; i++)
+         names.push_back(nodenames.intern("#tag"+lexical_cast<string>(i)));
+   }
+
+   void next(vector <unsigned> &linkpack) {
+      linkpack.clear();
+      unsigned size = 2 + rand()%3;
+      while (linkpack.size()<size) {
+         double u = rand()/(RAND_MAX+1.0);
+         unsigned rank = (unsigned)exp(u*log((double)names.size()));
+         unsigned name = names[rank-1];
+         if (find(linkpack.begin(), linkpack.end(), name)==linkpack.end())
+            linkpack.push_back(name);
+      }
+      sort(linkpack.begin(), linkpack.end());
+   }
+
+private:
+   vector <unsigned> names;
+};
+
+int main(int argc, char** argv) {
+   const unsigned vocabulary = 2000000;
+   const unsigned measured = 200000;
+   unsigned sizes[] = {2000, 20000, 200000};
+
+   name_table nodenames;
+   linkpack_generator gen(vocabulary, nodenames);
+   vector <unsigned> linkpack;
+
+   for (unsigned k=0; k<sizeof(sizes)/sizeof(sizes[0]); k++) {
+      clock_collectors mycc;
+      mycc.addnamedcollectors(2, "TTTTfindinstored", "TTTTaddedtostored");
+      net_collector mynet(sizes[k], nodenames, mycc, 0);
+
+      // fill the buffer so that the measured linkpacks cause evictions
+      for (unsigned i=0; i<2*sizes[k]; i++) {
+         gen.next(linkpack);
+         mynet.add_linkpack(linkpack, 1.0);
+      }
+
+      auto start = chrono::steady_clock::now();
+      for (unsigned i=0; i<measured; i++) {
+         gen.next(linkpack);
+         mynet.add_linkpack(linkpack, 1.0);
+      }
+      double elapsed = chrono::duration<double>(
+         chrono::steady_clock::now()-start).count();
+
+      printf("maxstored=%7u linkpacks=%u usec/linkpack=%8.3f\n",
+         sizes[k], measured, 1e6*elapsed/measured);
+   }
+   return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Benchmark of the throughput of parsing a dynamic network in the text
+ * format, the reader of the filtering tool against getline + istringstream,
+ * and of reading the same network converted into the binary format bdnet
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <util/bdnet.hpp>
+#include <util/mapped_file.hpp>
+#include <util/name_table.hpp>
+#include <util/text_reader.hpp>
+
+using namespace std;
+
+// the parsing used before the text_reader
+void get_weighted_linkpack( const char *bufch, name_table &nodenames,
+                   vector <unsigned> &linkpack, double &weight, time_t &time ) {
+   istringstream bufis(bufch);
+   bufis>>time;
+   if (!bufis.good()) return;
+   string node;
+   set<string> unique;
+   bufis>>node;
+   while (bufis.good()) {
+      unique.insert(node);
+      bufis>>node;
+   }
+   weight = atof(node.c_str());
+   linkpack.clear();
+   for (auto it=unique.begin(); it!=unique.end(); it++)
+      linkpack.push_back(nodenames.intern(*it));
+}
+
+void report(const char *method, double elapsed, size_t bytes,
+      unsigned long lines, unsigned long nodes) {
+   printf("%-22s lines=%lu nodes=%lu MB/s=%8.1f Mlines/s=%6.2f\n", method,
+      lines, nodes, bytes/elapsed/1e6, lines/elapsed/1e6);
+}
+
+int main(int argc, char** argv) {
+   string path = argc>1 ? argv[1] : "../data/osama.wdnet";
+   const unsigned repeats = 5;
+   vector <unsigned> linkpack;
+   double weight;
+   time_t time;
+
+   mapped_file input(path);
+   if (!input.is_open()) {
+      printf("Could not open %s\n", path.c_str());
+      return 1;
+   }
+
+   // getline + istringstream
+   {
+      name_table nodenames;
+      unsigned long lines=0, nodes=0;
+      auto start = chrono::steady_clock::now();
+      for (unsigned r=0; r<repeats; r++) {
+         ifstream inputnet(path.c_str());
+         static char bufch[100000];
+         while (inputnet.getline(bufch,100000)) {
+            get_weighted_linkpack(bufch, nodenames, linkpack, weight, time);
+            lines++;
+            nodes += linkpack.size();
+         }
+      }
+      double elapsed = chrono::duration<double>(
+         chrono::steady_clock::now()-start).count();
+      report("getline+istringstream", elapsed, repeats*input.size(),
+         lines, nodes);
+   }
+
+   // text_reader over the mapped file
+   {
+      name_table nodenames;
+      unsigned long lines=0, nodes=0;
+      auto start = chrono::steady_clock::now();
+      for (unsigned r=0; r<repeats; r++) {
+         text_reader reader(input.begin(), input.end(), true, nodenames);
+         while (reader.next(linkpack, weight, time)) {
+            lines++;
+            nodes += linkpack.size();
+         }
+      }
+      double elapsed = chrono::duration<double>(
+         chrono::steady_clock::now()-start).count();
+      report("text_reader", elapsed, repeats*input.size(), lines, nodes);
+   }
+
+   // bdnet_reader over the converted network, the throughput is given
+   // relative to the size of the text
+   {
+      ostringstream converted;
+      name_table textnames;
+      text_reader names(input.begin(), input.end(), true, textnames);
+      text_reader records(input.begin(), input.end(), true, textnames);
+      write_bdnet(names, records, textnames, true, converted);
+      string binary = converted.str();
+      printf("%-22s bytes=%lu (%.0f%% of the text)\n", "bdnet",
+         (unsigned long)binary.size(), 100.0*binary.size()/input.size());
+
+      name_table nodenames;
+      unsigned long lines=0, nodes=0;
+      auto start = chrono::steady_clock::now();
+      for (unsigned r=0; r<repeats; r++) {
+         bdnet_reader reader(binary.data(), binary.data()+binary.size(),
+            nodenames);
+         while (reader.next(linkpack, weight, time)) {
+            lines++;
+            nodes += linkpack.size();
+         }
+      }
+      double elapsed = chrono::duration<double>(
+         chrono::steady_clock::now()-start).count();
+      report("bdnet_reader", elapsed, repeats*input.size(), lines, nodes);
+   }
+   return 0;
+}
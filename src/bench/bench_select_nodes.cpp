@@ -0,0 +1,110 @@
+/*
+ * Benchmark of the selection of the strongest stored nodes done for each
+ * frame, sorting all the stored nodes by strength as it was done before
+ * against the partial selection of select_strongest
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <pms/clock_collector.hpp>
+#include <util/name_table.hpp>
+#include <viz/net_collector.hpp>
+#include <viz/node.hpp>
+
+using namespace std;
+
+// node names drawn from a vocabulary with a heavy-tailed popularity
+class linkpack_generator {
+public:
+   linkpack_generator(unsigned vocabulary, name_table &nodenames,
+         unsigned seed=1) {
+      srand(seed);
+      for (unsigned i=0; i<vocabulary; i++)
+         names.push_back(nodenames.intern("#tag"+lexical_cast<string>(i)));
+   }
+
+   void next(vector <unsigned> &linkpack) {
+      linkpack.clear();
+      unsigned size = 2 + rand()%3;
+      while (linkpack.size()<size) {
+         double u = rand()/(RAND_MAX+1.0);
+         unsigned rank = (unsigned)exp(u*log((double)names.size()));
+         unsigned name = names[rank-1];
+         if (find(linkpack.begin(), linkpack.end(), name)==linkpack.end())
+            linkpack.push_back(name);
+      }
+      sort(linkpack.begin(), linkpack.end());
+   }
+
+private:
+   vector <unsigned> names;
+};
+
+static void stored_nodes(net_collector &mynet, vector <node_the> &nodes) {
+   nodes.clear();
+   node_the tmpnode;
+   for (unsigned i=0; i<mynet.maxstored; i++)
+      if (mynet.ids[i]!=name_table::npos) {
+         tmpnode.id = mynet.ids[i];
+         tmpnode.pos = i;
+         tmpnode.str = mynet.net.get(i,i);
+         nodes.push_back(tmpnode);
+      }
+}
+
+// the selection as it was done before, with a full sort
+static void select_sorted(vector <node_the> &nodes, unsigned k,
+      vector <node_the> &selected) {
+   sort(nodes.begin(), nodes.end(), compare_node_strength<node_the>);
+   unsigned n = min<size_t>(k, nodes.size());
+   selected.assign(nodes.end()-n, nodes.end());
+   sort(selected.begin(), selected.end());
+}
+
+int main(int argc, char** argv) {
+   const unsigned vocabulary = 2000000;
+   unsigned sizes[] = {2000, 20000, 200000};
+   unsigned visualized[] = {50, 500};
+
+   name_table nodenames;
+   linkpack_generator gen(vocabulary, nodenames);
+   vector <unsigned> linkpack;
+   vector <node_the> nodes, selected;
+
+   for (unsigned k=0; k<sizeof(sizes)/sizeof(sizes[0]); k++) {
+      clock_collectors mycc;
+      mycc.addnamedcollectors(2, "TTTTfindinstored", "TTTTaddedtostored");
+      net_collector mynet(sizes[k], nodenames, mycc, 0);
+      for (unsigned i=0; i<2*sizes[k]; i++) {
+         gen.next(linkpack);
+         mynet.add_linkpack(linkpack, 1.0);
+      }
+      unsigned frames = max(20u, 4000000/sizes[k]);
+
+      for (unsigned v=0; v<sizeof(visualized)/sizeof(visualized[0]); v++) {
+         double elapsed[2];
+         for (unsigned method=0; method<2; method++) {
+            auto start = chrono::steady_clock::now();
+            for (unsigned f=0; f<frames; f++) {
+               stored_nodes(mynet, nodes);
+               if (method==0) select_sorted(nodes, visualized[v], selected);
+               else select_strongest(nodes, visualized[v]);
+            }
+            elapsed[method] = chrono::duration<double>(
+               chrono::steady_clock::now()-start).count();
+         }
+         printf("maxstored=%7u maxvisualized=%4u usec/frame: sort=%9.1f "
+            "select=%9.1f\n", sizes[k], visualized[v],
+            1e6*elapsed[0]/frames, 1e6*elapsed[1]/frames);
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Converts the events of the filtering tool from the binary format
+ * bdframes back into the JSON events of the Gephi Streaming API, as the
+ * tool writes them in a .json file. The frames are converted as they are
+ * read, so that the input may be a stream.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <viz/bdframes.hpp>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+   namespace po = boost::program_options;
+   po::options_description desc("Allowed options");
+
+   desc.add_options()
+      ("help", "show options")
+      ("input", po::value<string>()->default_value(""),
+         "Events in the bdframes format, - reads the standard input.")
+      ("output", po::value<string>()->default_value(""),
+         "Path of the JSON file to create, - writes the standard output.")
+      ;
+
+   po::variables_map vm;
+   po::store(po::parse_command_line(argc, argv, desc), vm);
+   po::notify(vm);
+
+   string input = vm["input"].as<string>();
+   string output = vm["output"].as<string>();
+   if (vm.count("help") || input=="" || output=="") {
+      cerr << desc << "\n";
+      exit(1);
+   }
+
+   ifstream inputfile;
+   if (input!="-") {
+      inputfile.open(input.c_str(), ios::binary);
+      if (!inputfile) {
+         cerr<<"Could not open the input file "<<input<<endl;
+         return -1;
+      }
+   }
+   ofstream outputfile;
+   if (output!="-") {
+      outputfile.open(output.c_str(), ios::binary);
+      if (!outputfile) {
+         cerr<<"Could not create the output file "<<output<<endl;
+         return -1;
+      }
+   }
+   istream &in = input=="-" ? cin : inputfile;
+   ostream &out = output=="-" ? cout : outputfile;
+
+   bdframes_reader frames(in);
+   string json;
+   unsigned long count = 0;
+   while (frames.next_frame(json)) {
+      out.write(json.data(), json.size());
+      json.clear();
+      count++;
+   }
+   out.flush();
+   if (frames.failed()) {
+      cerr<<"The input is not a complete bdframes file, "<<count
+          <<" frames converted"<<endl;
+      return -1;
+   }
+   if (!out) {
+      cerr<<"Could not write the output file "<<output<<endl;
+      return -1;
+   }
+   cerr<<"Converted "<<count<<" frames into "<<output<<endl;
+   return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Converts a dynamic network from the text formats sdnet and wdnet into
+ * the binary format bdnet, which the filtering tool reads without parsing.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <util/bdnet.hpp>
+#include <util/input_file.hpp>
+#include <util/text_reader.hpp>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+   namespace po = boost::program_options;
+   po::options_description desc("Allowed options");
+
+   desc.add_options()
+      ("help", "show options")
+      ("input", po::value<string>()->default_value(""),
+         "Dynamic network in the sdnet or wdnet format, files ending with "
+         ".gz are decompressed while they are read.")
+      ("inputformat", po::value<string>()->default_value(""),
+         "weighted for the wdnet format.")
+      ("output", po::value<string>()->default_value(""),
+         "Path of the bdnet file to create.")
+      ;
+
+   po::variables_map vm;
+   po::store(po::parse_command_line(argc, argv, desc), vm);
+   po::notify(vm);
+
+   string input = vm["input"].as<string>();
+   string output = vm["output"].as<string>();
+   bool weighted = vm["inputformat"].as<string>()=="weighted";
+   if (vm.count("help") || input=="" || output=="") {
+      cerr << desc << "\n";
+      exit(1);
+   }
+
+   // the input is read twice, a compressed one is decompressed twice
+   // instead of being kept
+   input_file namesfile(input), recordsfile(input);
+   if (!namesfile.is_open() || !recordsfile.is_open()) {
+      cout<<"Could not open the input file "<<input<<endl;
+      return -1;
+   }
+   name_table nodenames;
+   text_reader names(namesfile.begin(), namesfile.end(), weighted,
+      nodenames, namesfile.source());
+   text_reader records(recordsfile.begin(), recordsfile.end(), weighted,
+      nodenames, recordsfile.source());
+
+   ofstream outputfile(output.c_str(), ios::binary);
+   if (!outputfile) {
+      cout<<"Could not create the output file "<<output<<endl;
+      return -1;
+   }
+
+   bdnet_stats stats = write_bdnet(names, records, nodenames, weighted,
+      outputfile);
+   outputfile.close();
+   if (namesfile.failed() || recordsfile.failed()) {
+      cout<<"The decompression of the input file has failed"<<endl;
+      return -1;
+   }
+   if (!outputfile) {
+      cout<<"Could not write the output file "<<output<<endl;
+      return -1;
+   }
+   cout<<"Converted "<<stats.records<<" lines ("<<stats.malformed
+       <<" malformed) with "<<stats.nodes<<" nodes into "<<output<<endl;
+   return 0;
+}
@@ -0,0 +1,145 @@
+#include "async_writer.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace std;
+
+const size_t async_writer::maxcoalesced;
+
+namespace {
+
+double since(const chrono::steady_clock::time_point &start) {
+   return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+}
+
+async_writer::async_writer(const sink_type &sink, unsigned depth,
+      policy_type policy)
+   : sink(sink), depth(depth), policy(policy), nextstarts(true),
+     closed(false), maxqueue(0), writes(0), dropped(0),
+     coalesced(0), latency(0), maxlatency(0), blocked(0) {
+   if (depth>0) writer = thread(&async_writer::write, this);
+}
+
+async_writer::~async_writer() {
+   close();
+}
+
+void async_writer::push(string &data, bool ends) {
+   if (depth==0) {
+      auto start = chrono::steady_clock::now();
+      sink(data, ends);
+      double seconds = since(start);
+      data.clear();
+      lock_guard <mutex> l(lock);
+      written(seconds);
+      return;
+   }
+
+   unique_lock <mutex> l(lock);
+   while (queue.size()>=depth) {
+      if (policy==coalesce
+            && queue.back().data.size()+data.size()<=maxcoalesced) {
+         piece &last = queue.back();
+         last.data += data;
+         last.ends = ends;
+         nextstarts = ends;
+         coalesced++;
+         data.clear();
+         return;
+      }
+      // a piece of a frame already made is waited for, as is a piece
+      // that would grow the last one past maxcoalesced
+      auto start = chrono::steady_clock::now();
+      room.wait(l);
+      blocked += since(start);
+   }
+   queue.push_back(piece());
+   piece &p = queue.back();
+   p.data.swap(data);
+   p.ends = ends;
+   nextstarts = ends;
+   if (queue.size()>maxqueue) maxqueue = queue.size();
+   if (!spare.empty()) {
+      data.swap(spare.back());
+      spare.pop_back();
+   }
+   l.unlock();
+   ready.notify_one();
+}
+
+void async_writer::close() {
+   {
+      lock_guard <mutex> l(lock);
+      closed = true;
+   }
+   ready.notify_all();
+   if (writer.joinable()) writer.join();
+}
+
+void async_writer::write() {
+   string data;
+   unique_lock <mutex> l(lock);
+   for (;;) {
+      while (queue.empty() && !closed) ready.wait(l);
+      if (queue.empty()) return;
+      data.swap(queue.front().data);
+      bool ends = queue.front().ends;
+      queue.pop_front();
+      l.unlock();
+      room.notify_one();
+
+      auto start = chrono::steady_clock::now();
+      sink(data, ends);
+      double seconds = since(start);
+      data.clear();
+
+      l.lock();
+      written(seconds);
+      if (spare.size()<depth) {
+         spare.push_back(string());
+         spare.back().swap(data);
+      }
+   }
+}
+
+void async_writer::written(double seconds) {
+   writes++;
+   latency += seconds;
+   if (seconds>maxlatency) maxlatency = seconds;
+}
+
+bool async_writer::drop_frame() {
+   if (policy!=drop || depth==0) return false;
+   lock_guard <mutex> l(lock);
+   if (!nextstarts || queue.size()<depth) return false;
+   dropped++;
+   return true;
+}
+
+void async_writer::get_stats(char *stats) {
+   lock_guard <mutex> l(lock);
+   sprintf(stats, "output_queue=%2u, output_queue_max=%2u, "
+      "write_ms=%7.3f, write_ms_max=%7.3f, output_blocked_ms=%6.0f",
+      (unsigned)queue.size(), maxqueue,
+      writes>0 ? 1e3*latency/writes : 0.0, 1e3*maxlatency, 1e3*blocked);
+   maxqueue = queue.size();
+   writes = 0;
+   latency = maxlatency = blocked = 0;
+}
+
+void async_writer::get_totals(char *totals) {
+   lock_guard <mutex> l(lock);
+   sprintf(totals, "frames dropped: %lu, pieces coalesced: %lu", dropped,
+      coalesced);
+}
+
+bool async_writer::parse_policy(const string &name, policy_type &policy) {
+   if (name=="block") policy = block;
+   else if (name=="drop") policy = drop;
+   else if (name=="coalesce") policy = coalesce;
+   else return false;
+   return true;
+}
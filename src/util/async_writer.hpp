@@ -0,0 +1,89 @@
+#ifndef ASYNC_WRITER_HPP
+#define ASYNC_WRITER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes the output of the frames in a separate thread, so that a slow disk
+// or server does not stall the reading and drawing of the frames. The
+// frame thread hands over its buffer and gets back one already written,
+// which keeps its capacity, so that the buffers are swapped rather than
+// copied. At most depth pieces of output wait for the writer; when they
+// are full, the policy decides whether the frame thread waits for the
+// writer, or appends its piece to the last one waiting so that they are
+// written together, as long as the last one stays within maxcoalesced
+// bytes, and otherwise waits for the writer, so that the memory held stays
+// bounded. The frames are differences from the frame before, so none is
+// dropped once handed over: with the drop policy the frame thread asks
+// drop_frame before it makes a frame, and a frame not made leaves its
+// changes to the next one made. A frame may be handed over in several
+// pieces, the last of which ends it. With a depth of 0 the pieces are
+// written by the frame thread as they are handed over.
+
+class async_writer {
+public:
+   enum policy_type {block, drop, coalesce};
+   // writes a piece of output, which may end its frame
+   typedef std::function <void (const std::string &data, bool ends)>
+      sink_type;
+
+   async_writer(const sink_type &sink, unsigned depth, policy_type policy);
+   ~async_writer();
+
+   // hands the data over to the writer, leaving data empty
+   void push(std::string &data, bool ends);
+   // with the drop policy, whether the next frame is not to be made as the
+   // queue is full, which counts it as dropped
+   bool drop_frame();
+   // waits until the data handed over is written, no more may be pushed
+   void close();
+
+   // the queue depth and the write latency since the last call, as
+   // name=value pairs
+   void get_stats(char *stats);
+   // the frames dropped and the pieces coalesced in total
+   void get_totals(char *totals);
+
+   // the policy of the names block, drop and coalesce
+   static bool parse_policy(const std::string &name, policy_type &policy);
+
+private:
+   async_writer(const async_writer &);
+   async_writer& operator=(const async_writer &);
+
+   struct piece {
+      std::string data;
+      bool ends;
+   };
+
+   static const std::size_t maxcoalesced = 1<<23;
+
+   void write();
+   void written(double seconds);
+
+   const sink_type sink;
+   const unsigned depth;
+   const policy_type policy;
+
+   std::mutex lock;
+   std::condition_variable ready; // a piece waits or the writer is closed
+   std::condition_variable room; // a piece has left the queue
+   std::deque <piece> queue;
+   std::vector <std::string> spare; // written buffers, for their capacity
+   bool nextstarts; // the next piece pushed starts a frame
+   bool closed;
+   std::thread writer;
+
+   // stats since the last call of get_stats, and totals
+   unsigned maxqueue;
+   unsigned long writes, dropped, coalesced;
+   double latency, maxlatency, blocked;
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include "bdnet.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <util/text_reader.hpp>
+
+using namespace std;
+
+static const char magic[8] = { 'b', 'd', 'n', 'e', 't', 0, 0, 1 };
+static const size_t headersize = 8+4+4+8+8;
+
+static void put_fixed(vector <char> &out, unsigned long long value,
+      unsigned bytes) {
+   for (unsigned i=0; i<bytes; i++) out.push_back(char(value>>(8*i)));
+}
+
+static void put_varint(vector <char> &out, unsigned long long value) {
+   while (value>=0x80) {
+      out.push_back(char(value|0x80));
+      value >>= 7;
+   }
+   out.push_back(char(value));
+}
+
+static unsigned long long get_fixed(const unsigned char *p, unsigned bytes) {
+   unsigned long long value = 0;
+   for (unsigned i=0; i<bytes; i++) value |= (unsigned long long)p[i]<<(8*i);
+   return value;
+}
+
+// returns false if the input ends inside the varint
+static inline bool get_varint(const unsigned char *&p, const unsigned char *end,
+      unsigned long long &value) {
+   value = 0;
+   for (unsigned shift=0; p<end && shift<64; shift+=7) {
+      unsigned char byte = *p++;
+      value |= (unsigned long long)(byte&0x7f)<<shift;
+      if (!(byte&0x80)) return true;
+   }
+   return false;
+}
+
+bdnet_stats write_bdnet(link_reader &names, link_reader &records,
+      const name_table &nodenames, bool weighted, ostream &output) {
+   vector <unsigned> linkpack;
+   double weight = 1;
+   time_t time = 0;
+
+   // the first pass gives the ids in the order in which the text reader
+   // finds the names, the second one then finds all the names known
+   bdnet_stats stats = { 0, 0, 0 };
+   while (names.next(linkpack, weight, time)) stats.records++;
+   stats.malformed = names.get_malformed();
+   stats.nodes = nodenames.size();
+
+   vector <char> out(magic, magic+sizeof(magic));
+   put_fixed(out, weighted ? 1 : 0, 4);
+   put_fixed(out, stats.nodes, 4);
+   put_fixed(out, stats.records, 8);
+   put_fixed(out, stats.malformed, 8);
+   for (unsigned id=0; id<stats.nodes; id++) {
+      put_varint(out, nodenames.length(id));
+      out.insert(out.end(), nodenames.c_str(id),
+         nodenames.c_str(id)+nodenames.length(id));
+   }
+
+   time_t lasttime = 0;
+   double lastweight = 1;
+   time = 0;
+   while (records.next(linkpack, weight, time)) {
+      long long diff = (long long)time-lasttime;
+      put_varint(out, ((unsigned long long)diff<<1)^(diff>>63));
+      lasttime = time;
+      bool sameweight = weighted && weight==lastweight;
+      if (weighted) put_varint(out, linkpack.size()<<1|sameweight);
+      else put_varint(out, linkpack.size());
+      unsigned last = 0;
+      for (unsigned i=0; i<linkpack.size(); i++) {
+         put_varint(out, linkpack[i]-last);
+         last = linkpack[i];
+      }
+      if (weighted && !sameweight) {
+         unsigned long long bits;
+         memcpy(&bits, &weight, sizeof(bits));
+         put_fixed(out, bits, 8);
+         lastweight = weight;
+      }
+      if (out.size()>(1<<20)) {
+         output.write(&out[0], out.size());
+         out.clear();
+      }
+   }
+   output.write(&out[0], out.size());
+   return stats;
+}
+
+bool bdnet_reader::recognizes(const char *begin, const char *end) {
+   return end-begin>=8 && memcmp(begin, magic, 8)==0;
+}
+
+bdnet_reader::bdnet_reader(const char *begin, const char *end,
+      name_table &nodenames, input_source *source)
+   : pos(begin), end(end), source(source), weighted(false), ordered(true),
+     records(0), malformed(0), lasttime(0), lastweight(1) {
+   while (size_t(this->end-pos)<headersize && refill());
+   if (size_t(this->end-pos)<headersize || !recognizes(pos, this->end)) {
+      pos = this->end;
+      this->source = 0;
+      return;
+   }
+   const unsigned char *p = (const unsigned char*)pos;
+   weighted = get_fixed(p+8, 4)&1;
+   unsigned nodes = get_fixed(p+12, 4);
+   records = get_fixed(p+16, 8);
+   malformed = get_fixed(p+24, 8);
+   pos += headersize;
+
+   ids.resize(nodes);
+   for (unsigned id=0; id<nodes; ) {
+      p = (const unsigned char*)pos;
+      unsigned long long length;
+      if (!get_varint(p, (const unsigned char*)this->end, length)
+            || length>size_t(this->end-(const char*)p)) {
+         if (refill()) continue;
+         ids.resize(id);
+         pos = this->end;
+         this->source = 0;
+         return;
+      }
+      ids[id] = nodenames.intern((const char*)p, length);
+      if (id>0 && ids[id]<ids[id-1]) ordered = false;
+      pos = (const char*)p+length;
+      id++;
+   }
+}
+
+bool bdnet_reader::refill() {
+   return source && source->refill(pos, end);
+}
+
+bool bdnet_reader::next(vector <unsigned> &linkpack, double &weight,
+      time_t &time) {
+   while (!decode(linkpack)) if (!refill()) return false;
+   time = lasttime;
+   if (weighted) weight = lastweight;
+   return true;
+}
+
+bool bdnet_reader::decode(vector <unsigned> &linkpack) {
+   const unsigned char *p = (const unsigned char*)pos;
+   const unsigned char *e = (const unsigned char*)end;
+   unsigned long long diff, nodes, id = 0, gap;
+   if (!get_varint(p, e, diff) || !get_varint(p, e, nodes)) return false;
+   bool sameweight = false;
+   if (weighted) {
+      sameweight = nodes&1;
+      nodes >>= 1;
+   }
+
+   linkpack.clear();
+   for (unsigned long long i=0; i<nodes; i++) {
+      if (!get_varint(p, e, gap)) return false;
+      id += gap;
+      // a broken file ends here, as the next records cannot be trusted
+      if (id>=ids.size()) {
+         pos = end;
+         source = 0;
+         return false;
+      }
+      linkpack.push_back(ids[id]);
+   }
+   if (!ordered) sort(linkpack.begin(), linkpack.end());
+   if (weighted && !sameweight) {
+      if (e-p<8) return false;
+      unsigned long long bits = get_fixed(p, 8);
+      memcpy(&lastweight, &bits, sizeof(lastweight));
+      p += 8;
+   }
+   lasttime += (long long)(diff>>1)^-(long long)(diff&1);
+   pos = (const char*)p;
+   return true;
+}
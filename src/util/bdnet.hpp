@@ -0,0 +1,78 @@
+#ifndef BDNET_HPP
+#define BDNET_HPP
+
+#include <ctime>
+#include <ostream>
+#include <vector>
+
+#include <util/input_source.hpp>
+#include <util/link_reader.hpp>
+#include <util/name_table.hpp>
+
+// Binary dynamic network format, holding the linkpacks of a sdnet or
+// wdnet file in the same order, so that it is read without any parsing.
+// All integers are little-endian, varints use 7 bits per byte with the
+// lowest group first.
+//
+//    header   "bdnet\0\0\1", u32 flags (1: weighted), u32 number of nodes,
+//             u64 number of records, u64 number of malformed lines
+//    nodes    for each node id from 0: varint length, name bytes
+//    records  varint zigzag difference to the previous timestamp (the
+//             first one to 0), varint number of nodes, varint first id
+//             and the differences between the following sorted ids;
+//             in weighted networks the number of nodes is shifted left
+//             by one bit, set when the weight is the one of the previous
+//             record (the first one to 1), otherwise the weight follows
+//             as a 64-bit double
+//
+// Malformed lines of the text become records without nodes that keep
+// the previous timestamp, as the text reader gives them.
+
+struct bdnet_stats {
+   unsigned long nodes, records, malformed;
+};
+
+// converts a sdnet or wdnet network into the binary format; both readers
+// read the same text with the same empty name table, the first one gives
+// the dictionary and the second one the records
+bdnet_stats write_bdnet(link_reader &names, link_reader &records,
+      const name_table &nodenames, bool weighted, std::ostream &output);
+
+class bdnet_reader : public link_reader {
+public:
+   // the content starts with the header of the format, which is
+   // recognized from its first 8 bytes
+   static bool recognizes(const char *begin, const char *end);
+
+   // reads the content between begin and end, followed by the chunks of
+   // the source if one is given, and interns all the node names of the
+   // dictionary into the table
+   bdnet_reader(const char *begin, const char *end, name_table &nodenames,
+         input_source *source=0);
+
+   bool is_weighted() const { return weighted; }
+   unsigned long get_records() const { return records; }
+
+   virtual bool next(std::vector <unsigned> &linkpack, double &weight,
+         time_t &time);
+   virtual bool ready() { return pos<end || !source || source->ready(); }
+   virtual void close() { if (source) source->close(); }
+   virtual unsigned long get_malformed() const { return malformed; }
+
+private:
+   // decodes the record at pos, returns false if it is not complete
+   bool decode(std::vector <unsigned> &linkpack);
+   // gets the next chunk of the source
+   bool refill();
+
+   const char *pos, *end;
+   input_source *source;
+   bool weighted;
+   bool ordered; // the table ids grow with the ids of the file
+   unsigned long records, malformed;
+   time_t lasttime;
+   double lastweight;
+   std::vector <unsigned> ids; // table ids of the node ids of the file
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "chunked_input.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+void chunked_input::start() {
+   producer = thread(&chunked_input::run, this);
+}
+
+void chunked_input::stop() {
+   if (!producer.joinable()) return;
+   ring.close();
+   producer.join();
+}
+
+void chunked_input::run() {
+   while (true) {
+      chunk *c = ring.acquire();
+      if (!c) return;
+      c->data.resize(chunksize);
+      long got = read_chunk(&c->data[0], chunksize);
+      c->data.resize(got>0 ? got : 0);
+      c->last = got<=0;
+      c->failed = got<0;
+      ring.publish();
+      if (c->last) return;
+   }
+}
+
+bool chunked_input::refill(const char *&pos, const char *&end) {
+   if (finished) return false;
+   chunk *c = ring.is_closed() ? 0 : ring.front();
+   if (!c || c->last) {
+      finished = true;
+      if (c && c->failed) error = true;
+      return false;
+   }
+
+   // the unconsumed bytes lie in the window, or there are none
+   size_t keep = end-pos;
+   if (keep) memmove(&window[0], pos, keep);
+   window.resize(keep);
+   window.insert(window.end(), c->data.begin(), c->data.end());
+   ring.release();
+
+   pos = &window[0];
+   end = pos+window.size();
+   return true;
+}
+
+bool chunked_input::ready() {
+   return finished || ring.peek();
+}
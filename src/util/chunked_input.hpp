@@ -0,0 +1,63 @@
+#ifndef CHUNKED_INPUT_HPP
+#define CHUNKED_INPUT_HPP
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <util/input_source.hpp>
+#include <util/spsc_ring.hpp>
+
+// Input read in a separate thread, which hands the chunks it reads to the
+// reader through a bounded ring, so that the input is never kept as a
+// whole and the reading overlaps with the parsing. The derived classes
+// say how a chunk is read; they start the thread once they are built and
+// stop it before they are destroyed.
+
+class chunked_input : public input_source {
+public:
+   virtual ~chunked_input() { }
+
+   // the reading stopped at an error before the end of the input
+   bool failed() const { return error; }
+
+   virtual bool refill(const char *&pos, const char *&end);
+   virtual bool ready();
+   // the read_chunk waiting for the input sees it through stopping()
+   virtual void close() { ring.close(); }
+
+protected:
+   chunked_input() : ring(ringchunks), finished(false), error(false) { }
+
+   void start();
+   void stop();
+   bool stopping() const { return ring.is_closed(); }
+
+   // reads at most size bytes, returns the number of bytes read, 0 at the
+   // end of the input or -1 at an error
+   virtual long read_chunk(char *data, size_t size) = 0;
+
+private:
+   chunked_input(const chunked_input &);
+   chunked_input& operator=(const chunked_input &);
+
+   struct chunk {
+      std::vector <char> data;
+      bool last, failed;
+   };
+
+   static const size_t chunksize = 1<<20;
+   static const unsigned ringchunks = 8;
+
+   void run();
+
+   spsc_ring <chunk> ring;
+   std::thread producer;
+
+   // reader state
+   std::vector <char> window;
+   bool finished;
+   std::atomic <bool> error;
+};
+
+#endif
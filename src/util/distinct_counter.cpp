@@ -0,0 +1,60 @@
+#include "distinct_counter.hpp"
+
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+// The count is estimated with the improved estimator of O. Ertl, "New
+// cardinality estimation algorithms for HyperLogLog sketches" (2017),
+// which corrects the registers still at 0 and those at the largest rank
+// on its own, so it needs neither the linear counting of the small counts
+// nor the tables of bias corrections of the original estimator.
+
+namespace {
+
+double sigma(double x) {
+   if (x==1) return numeric_limits<double>::infinity();
+   double y = 1, z = x, last;
+   do {
+      x *= x;
+      last = z;
+      z += x*y;
+      y += y;
+   } while (z!=last);
+   return z;
+}
+
+double tau(double x) {
+   if (x==0 || x==1) return 0;
+   double y = 1, z = 1-x, last;
+   do {
+      x = sqrt(x);
+      last = z;
+      y *= 0.5;
+      z -= (1-x)*(1-x)*y;
+   } while (z!=last);
+   return z/3;
+}
+
+}
+
+distinct_counter::distinct_counter(bool exact)
+   : exact(exact), distinct(0) {
+   if (!exact) registers.assign(1u<<precision, 0);
+}
+
+unsigned long distinct_counter::count() const {
+   if (exact) return distinct;
+
+   // the registers of each rank, which goes up to q+1
+   const unsigned q = 64-precision;
+   vector <unsigned> ranks(q+2, 0);
+   for (size_t r=0; r<registers.size(); r++) ranks[registers[r]]++;
+
+   double m = registers.size();
+   double z = m*tau(1-ranks[q+1]/m);
+   for (unsigned k=q; k>=1; k--) z = 0.5*(z+ranks[k]);
+   z += m*sigma(ranks[0]/m);
+   return (unsigned long)(m*m/(2*log(2.0))/z+0.5);
+}
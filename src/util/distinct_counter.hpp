@@ -0,0 +1,65 @@
+#ifndef DISTINCT_COUNTER_HPP
+#define DISTINCT_COUNTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Counts the distinct ids inserted into it. The exact count keeps one bit
+// for every id up to the largest one inserted, which is small next to the
+// names the ids stand for. The estimated count keeps a HyperLogLog sketch
+// of a constant 16 kB instead, whose relative standard error is about
+// 0.8% from a few ids up to billions of them. Both cost O(1) per insert.
+
+class distinct_counter {
+public:
+   distinct_counter(bool exact);
+
+   void insert(unsigned id) {
+      if (exact) {
+         std::size_t word = id>>6;
+         if (word>=bits.size()) bits.resize(word+word/2+1, 0);
+         uint64_t bit = (uint64_t)1<<(id&63);
+         if (!(bits[word]&bit)) {
+            bits[word] |= bit;
+            distinct++;
+         }
+         return;
+      }
+      uint64_t h = hash(id);
+      unsigned r = h>>(64-precision);
+      // the rank of the first set bit among the remaining ones, the
+      // sentinel bit bounds it when they are all 0
+      uint64_t rest = h<<precision | (uint64_t)1<<(precision-1);
+      unsigned char rank = __builtin_clzll(rest)+1;
+      if (rank>registers[r]) registers[r] = rank;
+   }
+
+   template <class Iter>
+   void insert(Iter first, Iter last) {
+      for (; first!=last; first++) insert(*first);
+   }
+
+   unsigned long count() const;
+
+   bool is_exact() const { return exact; }
+
+private:
+   static const unsigned precision = 14; // 2^14 registers
+
+   static uint64_t hash(uint64_t x) {
+      x ^= x>>33;
+      x *= 0xff51afd7ed558ccdULL;
+      x ^= x>>33;
+      x *= 0xc4ceb9fe1a85ec53ULL;
+      x ^= x>>33;
+      return x;
+   }
+
+   bool exact;
+   std::vector <uint64_t> bits;
+   unsigned long distinct;
+   std::vector <unsigned char> registers;
+};
+
+#endif
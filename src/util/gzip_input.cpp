@@ -0,0 +1,22 @@
+#include "gzip_input.hpp"
+
+using namespace std;
+
+gzip_input::gzip_input(const string &path) : file(gzopen(path.c_str(), "rb")) {
+   if (!file) return;
+   gzbuffer(file, 1<<17);
+   start();
+}
+
+gzip_input::~gzip_input() {
+   stop();
+   if (file) gzclose(file);
+}
+
+long gzip_input::read_chunk(char *data, size_t size) {
+   int got = gzread(file, data, size);
+   // a truncated file ends without an error of the reading
+   int status = Z_OK;
+   if (got==0) gzerror(file, &status);
+   return status==Z_OK ? got : -1;
+}
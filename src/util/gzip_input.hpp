@@ -0,0 +1,27 @@
+#ifndef GZIP_INPUT_HPP
+#define GZIP_INPUT_HPP
+
+#include <string>
+
+#include <zlib.h>
+
+#include <util/chunked_input.hpp>
+
+// Reads a gzip compressed file, decompressing it in a separate thread.
+// Files that are not compressed are read as they are.
+
+class gzip_input : public chunked_input {
+public:
+   gzip_input(const std::string &path);
+   ~gzip_input();
+
+   bool is_open() const { return file!=0; }
+
+protected:
+   virtual long read_chunk(char *data, size_t size);
+
+private:
+   gzFile file;
+};
+
+#endif
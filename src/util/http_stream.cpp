@@ -0,0 +1,283 @@
+#include "http_stream.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+// a request is given up after these many tries at the end or once the
+// stream is stopped, when its frames would otherwise be retried for ever;
+// once one has been given up, the later ones are tried once
+static const unsigned finaltries = 3;
+
+bool http_stream::parse_url(const string &url, string &host, string &port,
+      string &target) {
+   const string scheme = "http://";
+   if (url.compare(0, scheme.size(), scheme)!=0) return false;
+   size_t start = scheme.size();
+   size_t slash = url.find('/', start);
+   string authority = url.substr(start, slash==string::npos ? string::npos
+                                                           : slash-start);
+   target = slash==string::npos ? "/" : url.substr(slash);
+   // an IPv6 address is in brackets
+   size_t colon = authority.rfind(':');
+   if (colon!=string::npos && authority.find(']', colon)==string::npos) {
+      host = authority.substr(0, colon);
+      port = authority.substr(colon+1);
+   }
+   else {
+      host = authority;
+      port = "80";
+   }
+   if (host.size()>1 && host[0]=='[' && host[host.size()-1]==']')
+      host = host.substr(1, host.size()-2);
+   return !host.empty() && !port.empty();
+}
+
+http_stream::http_stream(const string &url, unsigned batch, unsigned retries,
+      double timeout, const volatile sig_atomic_t *going)
+   : batch(max(1u, batch)), retries(retries), timeout(timeout), going(going),
+     stopped(false), gaveup(false), fd(-1), keepalive(false), sent(0),
+     frames(0), partial(false), dropping(false), connections(0), resent(0),
+     lost(0) {
+   valid = parse_url(url, host, port, target);
+}
+
+http_stream::~http_stream() {
+   if (valid && !request.empty()) deliver(true, finaltries);
+   disconnect();
+}
+
+bool http_stream::send(const string &data, bool ends) {
+   if (!valid) return false;
+   if (dropping) {
+      dropping = !ends;
+      return false;
+   }
+   // an empty chunk would end the request
+   if (!data.empty()) {
+      if (request.empty()) {
+         request = "POST "+target+" HTTP/1.1\r\nHost: "+host;
+         if (port!="80") request += ":"+port;
+         request += "\r\nTransfer-Encoding: chunked\r\n\r\n";
+      }
+      char size[24];
+      request.append(size, sprintf(size, "%lx\r\n",
+         (unsigned long)data.size()));
+      request += data;
+      request += "\r\n";
+      if (!partial) frames++;
+      partial = !ends;
+   }
+   else if (ends) partial = false;
+   return deliver(ends && frames>=batch, retries);
+}
+
+// a frame not whole yet is split, its rest goes in the next request
+bool http_stream::flush() {
+   if (!valid) return false;
+   if (request.empty()) return true;
+   return deliver(true, retries);
+}
+
+// writes what the connection has not got of the request, and the end of
+// the request with its response when it is ending
+bool http_stream::deliver(bool ending, unsigned tries) {
+   if (request.empty()) return true;
+   if (ending) request += "0\r\n\r\n";
+   // the server may have closed a connection left idle
+   if (fd>=0 && sent==0 && answered_early()) disconnect();
+   double wait = 0.1;
+   for (unsigned attempt=1; ; attempt++) {
+      bool ok = (fd>=0 || connect())
+         && !(sent>0 && answered_early())
+         && write_all(request.data()+sent, request.size()-sent)
+         && (!ending || read_response());
+      if (ok) {
+         if (ending) {
+            request.clear();
+            frames = 0;
+            partial = false;
+            sent = 0;
+            if (!keepalive) disconnect();
+         }
+         return true;
+      }
+
+      if (sent>0) resent += frames;
+      disconnect();
+      unsigned limit = tries;
+      if (stopping() && (limit==0 || limit>finaltries))
+         limit = gaveup ? 1 : finaltries;
+      if (limit>0 && attempt>=limit) {
+         cout<<"Could not send to "<<host<<":"<<port<<", "<<frames
+             <<" frames are lost."<<endl;
+         lost += frames;
+         request.clear();
+         frames = 0;
+         dropping = partial;
+         partial = false;
+         gaveup = stopping();
+         return false;
+      }
+      pause(wait);
+      wait = min(2*wait, 5.0);
+   }
+}
+
+// waits before trying again, the wait ends early when the stream is
+// stopped meanwhile
+void http_stream::pause(double seconds) {
+   bool wasstopping = stopping();
+   cout<<"The connection to "<<host<<":"<<port<<" failed, trying again in "
+       <<seconds<<" s."<<endl;
+   for (double left=seconds; left>0 && wasstopping==stopping(); left-=0.1)
+      usleep((useconds_t)(min(left, 0.1)*1e6));
+}
+
+bool http_stream::connect() {
+   addrinfo hints = addrinfo(), *addresses;
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses)!=0)
+      return false;
+   timeval tv;
+   tv.tv_sec = (time_t)timeout;
+   tv.tv_usec = (suseconds_t)((timeout-tv.tv_sec)*1e6);
+   for (addrinfo *a=addresses; a && fd<0; a=a->ai_next) {
+      fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (fd<0) continue;
+      // the timeouts bound also the connecting
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+      // each chunk is written whole, so that it goes out at once
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      if (::connect(fd, a->ai_addr, a->ai_addrlen)!=0) {
+         close(fd);
+         fd = -1;
+      }
+   }
+   freeaddrinfo(addresses);
+   if (fd<0) return false;
+   connections++;
+   keepalive = true;
+   sent = 0;
+   input.clear();
+   return true;
+}
+
+void http_stream::disconnect() {
+   if (fd>=0) close(fd);
+   fd = -1;
+   sent = 0;
+   input.clear();
+}
+
+bool http_stream::write_all(const char *data, size_t len) {
+   while (len>0) {
+      ssize_t got = ::send(fd, data, len, MSG_NOSIGNAL);
+      if (got<0 && errno==EINTR) continue;
+      if (got<=0) return false;
+      data += got;
+      len -= got;
+      sent += got;
+   }
+   return true;
+}
+
+// the server answers before the request ends only when it refuses it or
+// closes the connection
+bool http_stream::answered_early() {
+   pollfd p;
+   p.fd = fd;
+   p.events = POLLIN;
+   return poll(&p, 1, 0)>0;
+}
+
+bool http_stream::read_response() {
+   string status, line;
+   if (!read_line(status)) return false;
+   keepalive = status.compare(0, 9, "HTTP/1.1 ")==0;
+   size_t space = status.find(' ');
+   int code = space==string::npos ? 0 : atoi(status.c_str()+space+1);
+
+   long length = -1;
+   bool chunked = false;
+   while (true) {
+      if (!read_line(line)) return false;
+      if (line.empty()) break;
+      transform(line.begin(), line.end(), line.begin(), ::tolower);
+      if (line.compare(0, 15, "content-length:")==0)
+         length = atol(line.c_str()+15);
+      else if (line.compare(0, 18, "transfer-encoding:")==0)
+         chunked = line.find("chunked")!=string::npos;
+      else if (line.compare(0, 11, "connection:")==0) {
+         if (line.find("close")!=string::npos) keepalive = false;
+         if (line.find("keep-alive")!=string::npos) keepalive = true;
+      }
+   }
+
+   if (chunked) {
+      while (true) {
+         if (!read_line(line)) return false;
+         unsigned long size = strtoul(line.c_str(), 0, 16);
+         if (size==0) break;
+         if (!skip(size+2)) return false;
+      }
+      do if (!read_line(line)) return false;
+      while (!line.empty());
+   }
+   else if (length>=0) {
+      if (!skip(length)) return false;
+   }
+   // the body ends with the connection
+   else keepalive = false;
+
+   if (code<200 || code>=300) {
+      cout<<"The server "<<host<<":"<<port<<" answered: "<<status<<endl;
+      return false;
+   }
+   return true;
+}
+
+bool http_stream::read_more() {
+   char buffer[4096];
+   ssize_t got;
+   do got = recv(fd, buffer, sizeof(buffer), 0);
+   while (got<0 && errno==EINTR);
+   if (got<=0) return false;
+   input.append(buffer, got);
+   return true;
+}
+
+bool http_stream::read_line(string &line) {
+   size_t end;
+   while ((end = input.find("\r\n"))==string::npos) {
+      if (input.size()>(1<<16) || !read_more()) return false;
+   }
+   line.assign(input, 0, end);
+   input.erase(0, end+2);
+   return true;
+}
+
+bool http_stream::skip(size_t len) {
+   while (len>input.size()) {
+      len -= input.size();
+      input.clear();
+      if (!read_more()) return false;
+   }
+   input.erase(0, len);
+   return true;
+}
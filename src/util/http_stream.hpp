@@ -0,0 +1,87 @@
+#ifndef HTTP_STREAM_HPP
+#define HTTP_STREAM_HPP
+
+#include <atomic>
+#include <csignal>
+#include <string>
+
+// Streams frames of data to a server as the bodies of HTTP/1.1 POST requests
+// over one connection kept open. A frame is given in one or more pieces,
+// each sent at once as a chunk of the chunked transfer encoding, and a
+// request is ended after the last piece of a batch of frames, so that the
+// server acknowledges them with its response without a connection and a
+// round trip for every frame. The frames of a request are kept until it
+// is acknowledged: when the connection breaks, the server answers with an
+// error or does not answer within the timeout, they are all sent again in
+// a new request on a new connection, after waiting longer for each retry.
+// The server thus gets every frame at least once, and may get again the
+// frames it had before the failure. Once stopped, a request is given up
+// after a few tries, and the waits between them are cut short, so that
+// the stream ends even when the server cannot be reached.
+
+class http_stream {
+public:
+   // the url is http://host[:port]/target, the port is 80 if not given
+   static bool parse_url(const std::string &url, std::string &host,
+         std::string &port, std::string &target);
+
+   // batch frames per request; the frames are given up after the retries,
+   // 0 retries for ever; the timeout is in seconds; the stream stops when
+   // the flag going is cleared, by a signal handler for instance
+   http_stream(const std::string &url, unsigned batch, unsigned retries,
+         double timeout, const volatile sig_atomic_t *going=0);
+   // the last request is ended and waited for
+   ~http_stream();
+
+   // sends the data as a chunk of the current request, the last piece of
+   // its frame if it ends it; returns false if it was given up with the
+   // frames of its request, the rest of a frame given up is dropped
+   bool send(const std::string &data, bool ends=true);
+   // ends the current request and waits for its response
+   bool flush();
+   // gives up the requests after a few tries from now on, from any thread
+   void stop() { stopped = true; }
+
+   bool is_valid() const { return valid; }
+   unsigned long get_connections() const { return connections; }
+   unsigned long get_resent() const { return resent; }
+   unsigned long get_lost() const { return lost; }
+
+private:
+   http_stream(const http_stream &);
+   http_stream& operator=(const http_stream &);
+
+   bool deliver(bool ending, unsigned tries);
+   bool stopping() const { return stopped || (going && !*going); }
+   void pause(double seconds);
+   bool connect();
+   void disconnect();
+   bool write_all(const char *data, size_t len);
+   bool answered_early();
+   bool read_response();
+   bool read_more();
+   bool read_line(std::string &line);
+   bool skip(size_t len);
+
+   std::string host, port, target;
+   bool valid;
+   const unsigned batch;
+   const unsigned retries;
+   const double timeout;
+   const volatile sig_atomic_t *going;
+   std::atomic <bool> stopped;
+   bool gaveup; // a request was given up after the stream stopped
+
+   int fd; // -1 when not connected
+   bool keepalive; // the server keeps the connection after its response
+   std::string request; // the headers and the chunks not acknowledged
+   size_t sent; // bytes of the request written to the connection
+   unsigned frames; // frames in the request, the last one may not be whole
+   bool partial; // the last frame of the request is not whole yet
+   bool dropping; // the rest of a frame given up is dropped
+   std::string input; // received and not parsed yet
+
+   unsigned long connections, resent, lost;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef INDEXED_HEAP_HPP
+#define INDEXED_HEAP_HPP
+
+#include <vector>
+
+// Binary heap of element indices from the range [0, capacity) that keeps
+// a handle to the heap slot of every element, so that an element whose key
+// has changed can be moved to its new place in O(log n). The comparator
+// receives two element indices and returns true if the first one should be
+// closer to the top.
+
+template <class Compare>
+class indexed_heap {
+public:
+   static const unsigned npos = -1;
+
+   indexed_heap(unsigned capacity, Compare before)
+      : slot(capacity, npos), before(before) { }
+
+   bool empty() const { return heap.empty(); }
+   unsigned size() const { return heap.size(); }
+   unsigned top() const { return heap.front(); }
+   bool contains(unsigned i) const { return i<slot.size() && slot[i]!=npos; }
+
+   void resize(unsigned capacity) { slot.resize(capacity, npos); }
+
+   void push(unsigned i) {
+      slot[i] = heap.size();
+      heap.push_back(i);
+      sift_up(slot[i]);
+   }
+
+   void pop() { remove(heap.front()); }
+
+   void remove(unsigned i) {
+      unsigned s = slot[i];
+      unsigned last = heap.back();
+      heap.pop_back();
+      slot[i] = npos;
+      if (last==i) return;
+      heap[s] = last;
+      slot[last] = s;
+      update(last);
+   }
+
+   // call after the key of the element has been changed in any direction
+   void update(unsigned i) {
+      unsigned s = slot[i];
+      if (s>0 && before(heap[s], heap[(s-1)/2])) sift_up(s);
+      else sift_down(s);
+   }
+
+   void clear() {
+      for (unsigned k=0; k<heap.size(); k++) slot[heap[k]] = npos;
+      heap.clear();
+   }
+
+   const std::vector <unsigned>& elements() const { return heap; }
+
+private:
+   void sift_up(unsigned s) {
+      unsigned i = heap[s];
+      while (s>0) {
+         unsigned parent = (s-1)/2;
+         if (!before(i, heap[parent])) break;
+         heap[s] = heap[parent];
+         slot[heap[s]] = s;
+         s = parent;
+      }
+      heap[s] = i;
+      slot[i] = s;
+   }
+
+   void sift_down(unsigned s) {
+      unsigned i = heap[s];
+      unsigned n = heap.size();
+      while (true) {
+         unsigned child = 2*s+1;
+         if (child>=n) break;
+         if (child+1<n && before(heap[child+1], heap[child])) child++;
+         if (!before(heap[child], i)) break;
+         heap[s] = heap[child];
+         slot[heap[s]] = s;
+         s = child;
+      }
+      heap[s] = i;
+      slot[i] = s;
+   }
+
+   std::vector <unsigned> heap;
+   std::vector <unsigned> slot;
+   Compare before;
+};
+
+template <class Compare>
+const unsigned indexed_heap<Compare>::npos;
+
+#endif
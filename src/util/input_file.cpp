@@ -0,0 +1,35 @@
+#include "input_file.hpp"
+
+#include <sys/stat.h>
+
+#include <util/gzip_input.hpp>
+#include <util/stream_input.hpp>
+
+using namespace std;
+
+input_file::input_file(const string &path, bool follow)
+   : opened(false), stream(false), first(0), last(0) {
+   struct stat st;
+   if (path.size()>3 && path.compare(path.size()-3, 3, ".gz")==0) {
+      gzip_input *compressed = new gzip_input(path);
+      chunked.reset(compressed);
+      opened = compressed->is_open();
+   }
+   else if (path=="-" || follow
+         || (stat(path.c_str(), &st)==0 && !S_ISREG(st.st_mode))) {
+      stream_input *streamed = new stream_input(path, follow);
+      chunked.reset(streamed);
+      opened = streamed->is_open();
+      stream = true;
+   }
+   else {
+      mapped.reset(new mapped_file(path));
+      opened = mapped->is_open();
+      first = mapped->begin();
+      last = mapped->end();
+      return;
+   }
+
+   // enough of the content to recognize its format
+   while (opened && last-first<8 && chunked->refill(first, last));
+}
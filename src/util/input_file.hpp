@@ -0,0 +1,39 @@
+#ifndef INPUT_FILE_HPP
+#define INPUT_FILE_HPP
+
+#include <memory>
+#include <string>
+
+#include <util/chunked_input.hpp>
+#include <util/input_source.hpp>
+#include <util/mapped_file.hpp>
+
+// Input file of the tools. Files ending with .gz are decompressed while
+// they are read. The standard input (the path -), named pipes and other
+// special files, and followed files are read as streams, whose data may
+// keep arriving. Other files are mapped into memory as a whole.
+
+class input_file {
+public:
+   input_file(const std::string &path, bool follow=false);
+
+   bool is_open() const { return opened; }
+   // the input is a stream that may have no end
+   bool is_stream() const { return stream; }
+   // the failure of the reading is known at the end of the input
+   bool failed() const { return chunked && chunked->failed(); }
+
+   // the content available from the start
+   const char* begin() const { return first; }
+   const char* end() const { return last; }
+   // the chunks following the content, 0 if the content is whole
+   input_source* source() { return chunked.get(); }
+
+private:
+   std::unique_ptr <mapped_file> mapped;
+   std::unique_ptr <chunked_input> chunked;
+   bool opened, stream;
+   const char *first, *last;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef INPUT_SOURCE_HPP
+#define INPUT_SOURCE_HPP
+
+// Input that arrives in consecutive chunks, for the inputs that are not
+// available as a whole in memory. The reader keeps a contiguous window of
+// the input, to which each chunk is appended after the bytes the reader
+// has not consumed yet, so that a line or a record is never split.
+
+class input_source {
+public:
+   virtual ~input_source() { }
+
+   // moves the bytes between pos and end to the beginning of the window
+   // and appends the next chunk to them, pos and end are set to the new
+   // window; returns false and leaves them at the end of the input
+   virtual bool refill(const char *&pos, const char *&end) = 0;
+
+   // the next refill would not wait for the input
+   virtual bool ready() = 0;
+
+   // stops the input from any thread, the refills return false from then
+   // on, also one waiting for the input
+   virtual void close() { }
+};
+
+#endif
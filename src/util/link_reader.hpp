@@ -0,0 +1,30 @@
+#ifndef LINK_READER_HPP
+#define LINK_READER_HPP
+
+#include <ctime>
+#include <vector>
+
+// Source of the linkpacks of a dynamic network, read in the order of
+// their timestamps. The linkpack holds the sorted unique ids of its nodes.
+
+class link_reader {
+public:
+   virtual ~link_reader() { }
+
+   // reads the next linkpack, returns false at the end of the input; the
+   // weight is left untouched by unweighted inputs
+   virtual bool next(std::vector <unsigned> &linkpack, double &weight,
+         time_t &time) = 0;
+
+   // the next linkpack can be read without waiting for the input, or it is
+   // only missing the rest of a partly arrived line or record
+   virtual bool ready() { return true; }
+
+   // stops the input from an other thread, a next waiting for it returns
+   // false as at the end of the input
+   virtual void close() { }
+
+   virtual unsigned long get_malformed() const = 0;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "linkpack_pipeline.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+linkpack_pipeline::linkpack_pipeline(link_reader &reader,
+      const vector <unsigned> &first, double weight, time_t firsttime,
+      long interval, bool streaming, long lateness, name_table &nodenames)
+   : reader(reader), nodenames(nodenames), firsttime(firsttime),
+     interval(interval), pending(first), pendingweight(weight),
+     ring(ringbatches), unusedafter(0), current(0), position(0), done(false),
+     notsorted(false), malformed(0), dropped(0), consumed(0), added(0) {
+   if (streaming || lateness>0) reorder.reset(new reorder_buffer(lateness));
+   producer = thread(&linkpack_pipeline::read, this);
+}
+
+linkpack_pipeline::~linkpack_pipeline() {
+   // the reader thread may be waiting for the input of a stream
+   reader.close();
+   ring.close();
+   producer.join();
+}
+
+void linkpack_pipeline::read() {
+   vector <unsigned> linkpack;
+   linkpack.swap(pending);
+   double weight = pendingweight;
+   time_t time = firsttime, lasttime = firsttime;
+   bool have = true, ended = false, unsorted = false;
+   long frame = 1;
+
+   // linkpacks as they come from the reader when they are reordered
+   vector <unsigned> incoming;
+   double inweight = weight;
+   time_t intime = firsttime;
+   bool inputended = false;
+   bool recycling = nodenames.recycles();
+   unsigned long seq = 0;
+   if (reorder) {
+      reorder->push(linkpack, weight, time);
+      have = false;
+   }
+
+   while (!ended) {
+      batch *b = ring.acquire();
+      if (!b) return;
+      b->ids.clear();
+      b->ends.clear();
+      b->weights.clear();
+      b->times.clear();
+      b->frame = frame;
+      b->closes = false;
+      b->seq = ++seq;
+      if (recycling) release_unused(seq, have ? &linkpack : 0);
+
+      while (b->ends.size()<batchlinkpacks) {
+         if (!have && reorder) {
+            if (reorder->pop(linkpack, weight, time, inputended))
+               have = true;
+            else if (inputended) {
+               ended = true;
+               break;
+            }
+            else {
+               if (!b->ends.empty() && !reader.ready()) break;
+               if (reader.next(incoming, inweight, intime))
+                  reorder->push(incoming, inweight, intime);
+               else inputended = true;
+               continue;
+            }
+         }
+         else if (!have) {
+            if (!b->ends.empty() && !reader.ready()) break;
+            if (!reader.next(linkpack, weight, time)) {
+               ended = true;
+               break;
+            }
+            if (time<lasttime) {
+               ended = unsorted = true;
+               break;
+            }
+            lasttime = time;
+            have = true;
+         }
+         // the linkpacks reordered before the first one go to its frame
+         long linkframe = (time-firsttime)/interval+1;
+         if (linkframe>frame) {
+            b->closes = true;
+            frame = linkframe;
+            break;
+         }
+         b->ids.insert(b->ids.end(), linkpack.begin(), linkpack.end());
+         b->ends.push_back(b->ids.size());
+         if (recycling)
+            for (unsigned i=0; i<linkpack.size(); i++) seen(linkpack[i], seq);
+         b->weights.push_back(weight);
+         b->times.push_back(time);
+         have = false;
+      }
+      b->finished = ended;
+      b->unsorted = unsorted;
+      b->malformed = reader.get_malformed();
+      b->dropped = reorder ? reorder->get_dropped() : 0;
+      b->added = nodenames.get_added();
+      ring.publish();
+   }
+}
+
+// releases the ids given back that have not been in a batch after the
+// ones the consumer had, the linkpacks held back go to this batch or a
+// later one
+void linkpack_pipeline::release_unused(unsigned long seq,
+      const vector <unsigned> *held) {
+   unsigned long after;
+   {
+      lock_guard <mutex> hold(unusedlock);
+      if (unused.empty()) return;
+      releasing.swap(unused);
+      unused.clear();
+      after = unusedafter;
+   }
+   if (held)
+      for (unsigned i=0; i<held->size(); i++) seen((*held)[i], seq);
+   if (reorder) reorder->for_each_id([&](unsigned id) { seen(id, seq); });
+   for (unsigned i=0; i<releasing.size(); i++) {
+      unsigned id = releasing[i];
+      if (id>=lastseen.size() || lastseen[id]<=after) nodenames.release(id);
+   }
+   releasing.clear();
+}
+
+void linkpack_pipeline::release(const vector <unsigned> &ids) {
+   lock_guard <mutex> hold(unusedlock);
+   unused.assign(ids.begin(), ids.end());
+   unusedafter = consumed;
+}
+
+bool linkpack_pipeline::next(long frame, vector <unsigned> &linkpack,
+      double &weight, time_t &time, const time_point &deadline,
+      const volatile sig_atomic_t *going) {
+   while (!done) {
+      // the wait is cut into slices, in which the flag is checked
+      while (!current) {
+         time_point until = deadline;
+         if (going) until = min(deadline,
+            chrono::steady_clock::now()+chrono::milliseconds(100));
+         current = ring.front_until(until);
+         if (!current && (until==deadline || !*going)) return false;
+         position = 0;
+      }
+      if (current->frame>frame) return false;
+      if (position<current->ends.size()) {
+         unsigned begin = position ? current->ends[position-1] : 0;
+         linkpack.assign( current->ids.begin()+begin,
+            current->ids.begin()+current->ends[position] );
+         weight = current->weights[position];
+         time = current->times[position];
+         position++;
+         return true;
+      }
+      bool closes = current->closes && current->frame==frame;
+      done = current->finished;
+      notsorted = current->unsorted;
+      malformed = current->malformed;
+      dropped = current->dropped;
+      consumed = current->seq;
+      added = current->added;
+      current = 0;
+      ring.release();
+      if (closes) return false;
+   }
+   return false;
+}
@@ -0,0 +1,126 @@
+#ifndef LINKPACK_PIPELINE_HPP
+#define LINKPACK_PIPELINE_HPP
+
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <util/link_reader.hpp>
+#include <util/name_table.hpp>
+#include <util/reorder_buffer.hpp>
+#include <util/spsc_ring.hpp>
+
+// Reads the linkpacks in a separate thread, so that parsing the input
+// overlaps with collecting and drawing the frames. The reader thread
+// groups the linkpacks into batches and marks in each batch the frame of
+// its linkpacks and whether the frame ends with it, so that the frame
+// boundaries travel with the data and the consumer does not wait for the
+// first linkpack of the next frame to draw the current one. The reader
+// thread hands over the linkpacks it has before waiting for the input, so
+// that the linkpacks of a slow stream are not held back.
+//
+// The node names are interned by the reader thread only. The consumer may
+// look up the names of the ids it got, as the entries of the name table
+// never move and are written before the batch holding their ids is
+// published.
+//
+// When the name table recycles its ids, the consumer gives back the ids
+// of the nodes it holds no more, and the reader thread releases those of
+// them that have not been in a batch since the ones the consumer had, nor
+// are held back for a later batch, so that no id is given to a new name
+// while the consumer may still get it for the old one.
+
+class linkpack_pipeline {
+public:
+   typedef std::chrono::steady_clock::time_point time_point;
+
+   // the first linkpack has already been read from the reader, it opens
+   // the frames of the given interval; the linkpacks arriving late by at
+   // most the lateness are put back in order and the later ones dropped,
+   // except that a file that is not a stream ends at the first late
+   // linkpack if the lateness is 0; the names are those the reader interns
+   linkpack_pipeline(link_reader &reader, const std::vector <unsigned> &first,
+         double weight, time_t firsttime, long interval, bool streaming,
+         long lateness, name_table &nodenames);
+   ~linkpack_pipeline();
+
+   // gives the next linkpack of the frame (counted from 1), returns false
+   // when the frame has no more linkpacks, at the deadline or soon after
+   // the flag going is cleared, by a signal handler for instance; the
+   // linkpacks of earlier frames are given in the current one
+   bool next(long frame, std::vector <unsigned> &linkpack, double &weight,
+         time_t &time, const time_point &deadline=time_point::max(),
+         const volatile sig_atomic_t *going=0);
+
+   // the input has ended, or it was not sorted by time
+   bool finished() const { return done; }
+   bool unsorted() const { return notsorted; }
+   unsigned long get_malformed() const { return malformed; }
+   unsigned long get_dropped() const { return dropped; }
+   // names added to the table up to the linkpacks given
+   unsigned long get_added() const { return added; }
+
+   // gives back the ids not used by the consumer after the linkpacks it
+   // was given, replacing those given back before and not released yet
+   void release(const std::vector <unsigned> &ids);
+
+private:
+   linkpack_pipeline(const linkpack_pipeline &);
+   linkpack_pipeline& operator=(const linkpack_pipeline &);
+
+   struct batch {
+      std::vector <unsigned> ids; // ids of all the linkpacks
+      std::vector <unsigned> ends; // end of each linkpack in ids
+      std::vector <double> weights;
+      std::vector <time_t> times;
+      long frame;
+      bool closes; // the frame has no linkpacks after this batch
+      bool finished; // no batches after this one
+      bool unsorted;
+      unsigned long malformed; // lines malformed up to this batch
+      unsigned long dropped; // linkpacks too late up to this batch
+      unsigned long seq; // counted from 1
+      unsigned long added; // names added up to this batch
+   };
+
+   static const unsigned batchlinkpacks = 256;
+   static const unsigned ringbatches = 64;
+
+   void read();
+   void seen(unsigned id, unsigned long seq) {
+      if (id>=lastseen.size()) lastseen.resize(id+1, 0);
+      lastseen[id] = seq;
+   }
+   void release_unused(unsigned long seq, const std::vector <unsigned> *held);
+
+   link_reader &reader;
+   name_table &nodenames;
+   const time_t firsttime;
+   const long interval;
+   std::unique_ptr <reorder_buffer> reorder;
+   std::vector <unsigned> pending;
+   double pendingweight;
+
+   std::vector <unsigned long> lastseen; // last batch of each id
+   std::vector <unsigned> releasing; // the ids given back being released
+
+   spsc_ring <batch> ring;
+   std::thread producer;
+
+   // ids given back by the consumer and the last batch it had then
+   std::mutex unusedlock;
+   std::vector <unsigned> unused;
+   unsigned long unusedafter;
+
+   // consumer state
+   batch *current;
+   unsigned position;
+   bool done, notsorted;
+   unsigned long malformed, dropped, consumed, added;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+mapped_file::mapped_file(const string &path)
+   : opened(false), mapped(false), data(0), length(0) {
+   int fd = open(path.c_str(), O_RDONLY);
+   if (fd<0) return;
+   opened = true;
+
+   struct stat st;
+   if (fstat(fd, &st)==0 && S_ISREG(st.st_mode)) {
+      length = st.st_size;
+      if (length==0) { close(fd); return; }
+      void *p = mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p!=MAP_FAILED) {
+         madvise(p, length, MADV_SEQUENTIAL);
+         data = (const char*)p;
+         mapped = true;
+         close(fd);
+         return;
+      }
+   }
+
+   // not a regular file or it could not be mapped
+   const size_t chunk = 1<<20;
+   length = 0;
+   while (true) {
+      buffer.resize(length+chunk);
+      ssize_t got = read(fd, &buffer[length], chunk);
+      if (got<=0) break;
+      length += got;
+   }
+   buffer.resize(length);
+   data = length ? &buffer[0] : 0;
+   close(fd);
+}
+
+mapped_file::~mapped_file() {
+   if (mapped) munmap((void*)data, length);
+}
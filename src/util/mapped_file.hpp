@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <vector>
+
+// Read-only view of the whole content of a file. Regular files are mapped
+// into memory, so that they are read without copying and without a limit
+// on the length of the lines. Other files, such as pipes, are read into
+// a buffer.
+
+class mapped_file {
+public:
+   mapped_file(const std::string &path);
+   ~mapped_file();
+
+   bool is_open() const { return opened; }
+   const char* begin() const { return data; }
+   const char* end() const { return data+length; }
+   size_t size() const { return length; }
+
+private:
+   mapped_file(const mapped_file &);
+   mapped_file& operator=(const mapped_file &);
+
+   bool opened;
+   bool mapped;
+   const char *data;
+   size_t length;
+   std::vector <char> buffer;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "name_table.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+const unsigned name_table::npos;
+
+name_table::name_table(bool recycling)
+   : recycling(recycling), count(0), added(0), index(1u<<(32-blockbits)),
+     arenapos(0), arenaleft(0), slots(1024, npos) { }
+
+// FNV-1a
+unsigned name_table::hash(const char *str, unsigned len) {
+   unsigned h = 2166136261u;
+   for (unsigned i=0; i<len; i++) {
+      h ^= (unsigned char)str[i];
+      h *= 16777619u;
+   }
+   return h;
+}
+
+unsigned name_table::find(const char *str, unsigned len) const {
+   unsigned h = hash(str, len);
+   unsigned mask = slots.size()-1;
+   for (unsigned s=h&mask; slots[s]!=npos; s=(s+1)&mask) {
+      const entry &e = at(slots[s]);
+      if (e.hash==h && e.len==len && memcmp(e.str, str, len)==0)
+         return slots[s];
+   }
+   return npos;
+}
+
+unsigned name_table::intern(const char *str, unsigned len) {
+   unsigned h = hash(str, len);
+   unsigned mask = slots.size()-1;
+   unsigned s;
+   for (s=h&mask; slots[s]!=npos; s=(s+1)&mask) {
+      const entry &e = at(slots[s]);
+      if (e.hash==h && e.len==len && memcmp(e.str, str, len)==0)
+         return slots[s];
+   }
+
+   // a new name, it gets a released id if there is one
+   unsigned id;
+   if (!freeids.empty()) {
+      id = freeids.back();
+      freeids.pop_back();
+   }
+   else {
+      id = count++;
+      if (!index[id>>blockbits])
+         index[id>>blockbits].reset(new entry[blocksize]);
+   }
+   entry &e = index[id>>blockbits][id&(blocksize-1)];
+   e.str = store(str, len);
+   e.len = len;
+   e.hash = h;
+   slots[s] = id;
+   added++;
+   if (2*count>slots.size()) grow();
+   return id;
+}
+
+void name_table::release(unsigned id) {
+   if (!recycling || id>=count || is_released(id)) return;
+   entry &e = index[id>>blockbits][id&(blocksize-1)];
+   unsigned mask = slots.size()-1;
+   unsigned s = e.hash&mask;
+   while (slots[s]!=id) s=(s+1)&mask;
+   // the names after it in the run move back into the hole, unless their
+   // hash places them after the hole
+   for (unsigned next=(s+1)&mask; slots[next]!=npos; next=(next+1)&mask) {
+      unsigned home = at(slots[next]).hash&mask;
+      if (((next-home)&mask)>=((next-s)&mask)) {
+         slots[s] = slots[next];
+         s = next;
+      }
+   }
+   slots[s] = npos;
+
+   freeslots[slot_class(e.len+1)].push_back(const_cast<char*>(e.str));
+   e.str = 0;
+   freeids.push_back(id);
+}
+
+// the slot of the sizes up to smallslots is the size rounded up to 8
+// bytes, the slot of the larger ones the size rounded up to a power of 2
+unsigned name_table::slot_class(unsigned size) {
+   if (size<=smallslots) return (size+7)/8;
+   unsigned bits = 0;
+   while ((1u<<bits)<size) bits++;
+   return smallslots/8+bits;
+}
+
+// copies the name into the arena, names are null terminated; with the
+// ids recycled the name takes a slot released by a name of its size, or
+// a new slot of that size
+const char* name_table::store(const char *str, unsigned len) {
+   unsigned need = len+1;
+   char *slot = 0;
+   if (recycling) {
+      unsigned c = slot_class(need);
+      if (c>=freeslots.size()) freeslots.resize(c+1);
+      if (!freeslots[c].empty()) {
+         slot = freeslots[c].back();
+         freeslots[c].pop_back();
+      }
+      else need = c*8<=smallslots ? c*8 : 1u<<(c-smallslots/8);
+   }
+   if (slot) {
+      memcpy(slot, str, len);
+      slot[len] = 0;
+      return slot;
+   }
+   if (arenaleft<need) {
+      size_t size = need>arenablock ? need : arenablock;
+      arena.push_back(unique_ptr<char[]>(new char[size]));
+      arenapos = arena.back().get();
+      arenaleft = size;
+   }
+   char *result = arenapos;
+   memcpy(result, str, len);
+   result[len] = 0;
+   arenapos += need;
+   arenaleft -= need;
+   return result;
+}
+
+void name_table::grow() {
+   vector <unsigned> newslots(2*slots.size(), npos);
+   unsigned mask = newslots.size()-1;
+   for (unsigned id=0; id<count; id++) if (!is_released(id)) {
+      unsigned s = at(id).hash&mask;
+      while (newslots[s]!=npos) s=(s+1)&mask;
+      newslots[s] = id;
+   }
+   slots.swap(newslots);
+}
@@ -0,0 +1,93 @@
+#ifndef NAME_TABLE_HPP
+#define NAME_TABLE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Interns node names into consecutive integer ids. The names are copied
+// once into an arena of large character blocks and looked up through an
+// open-addressing hash table, so that interning an already known name
+// does not allocate. Names and their ids never move, so the pointers
+// returned by c_str() stay valid for the lifetime of the table.
+//
+// A table that recycles its ids lets the ids of the names no longer used
+// be released, and gives them to the names added later, so that a stream
+// of names that never ends is held in bounded memory. The names are then
+// stored in slots of a few sizes, which are reused by the names of the
+// same size; the name of a released id must not be looked up any more.
+
+class name_table {
+public:
+   static const unsigned npos = -1;
+
+   name_table(bool recycling=false);
+
+   // returns the id of the name, adding the name if it is not known yet
+   unsigned intern(const char *str, unsigned len);
+   unsigned intern(const std::string &name) {
+      return intern(name.data(), name.size());
+   }
+
+   // returns the id of the name or npos if the name is not known
+   unsigned find(const char *str, unsigned len) const;
+
+   const char* c_str(unsigned id) const { return at(id).str; }
+   unsigned length(unsigned id) const { return at(id).len; }
+   std::string str(unsigned id) const {
+      return std::string(at(id).str, at(id).len);
+   }
+
+   // the ids are below the size, those released included
+   unsigned size() const { return count; }
+
+   bool recycles() const { return recycling; }
+   // the id is given to a later name, if the table recycles its ids
+   void release(unsigned id);
+   bool is_released(unsigned id) const { return at(id).str==0; }
+   // names added in total, also those whose ids were released since
+   unsigned long get_added() const { return added; }
+   // identifies the name for counting the distinct ones: its id, or the
+   // hash of the name when the ids are recycled
+   unsigned key(unsigned id) const { return recycling ? at(id).hash : id; }
+
+private:
+   name_table(const name_table &);
+   name_table& operator=(const name_table &);
+
+   struct entry {
+      const char *str;
+      unsigned len;
+      unsigned hash;
+   };
+
+   // entries are kept in blocks referenced from a directory of fixed size
+   static const unsigned blockbits = 16;
+   static const unsigned blocksize = 1u<<blockbits;
+   static const size_t arenablock = 1<<20;
+   // names up to this size are stored in slots of multiples of 8 bytes
+   // when the ids are recycled, the longer ones in slots of powers of 2
+   static const unsigned smallslots = 256;
+
+   const entry& at(unsigned id) const {
+      return index[id>>blockbits][id&(blocksize-1)];
+   }
+
+   static unsigned hash(const char *str, unsigned len);
+   const char* store(const char *str, unsigned len);
+   static unsigned slot_class(unsigned size);
+   void grow();
+
+   const bool recycling;
+   unsigned count;
+   unsigned long added;
+   std::vector <unsigned> freeids;
+   std::vector <std::vector <char*> > freeslots; // by slot class
+   std::vector <std::unique_ptr <entry[]> > index;
+   std::vector <std::unique_ptr <char[]> > arena;
+   char *arenapos;
+   size_t arenaleft;
+   std::vector <unsigned> slots;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "reorder_buffer.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+bool reorder_buffer::push(const vector <unsigned> &linkpack, double weight,
+      time_t time) {
+   if (started && time<last) {
+      dropped++;
+      return false;
+   }
+   if (inorder.empty() && late.empty()) latest = time;
+
+   bool isinorder = inorder.empty() || time>=inorder.back().time;
+   record *r;
+   if (isinorder) {
+      // the slots of the queue keep the capacity of their ids
+      inorder.push_back(record());
+      r = &inorder.back();
+   }
+   else {
+      late.push_back(record());
+      r = &late.back();
+   }
+   r->time = time;
+   r->seq = seq++;
+   r->weight = weight;
+   r->ids.assign(linkpack.begin(), linkpack.end());
+   if (!isinorder) push_heap(late.begin(), late.end(), later());
+   if (time>latest) latest = time;
+   return true;
+}
+
+bool reorder_buffer::pop(vector <unsigned> &linkpack, double &weight,
+      time_t &time, bool end) {
+   if (empty()) return false;
+   bool fromheap = inorder.empty()
+      || (!late.empty() && later()(inorder.front(), late.front()));
+   record &r = fromheap ? late.front() : inorder.front();
+   if (!end && r.time+lateness>latest) return false;
+
+   linkpack.swap(r.ids);
+   weight = r.weight;
+   time = r.time;
+   if (fromheap) {
+      pop_heap(late.begin(), late.end(), later());
+      late.pop_back();
+   }
+   else inorder.pop_front();
+   started = true;
+   last = time;
+   return true;
+}
@@ -0,0 +1,67 @@
+#ifndef REORDER_BUFFER_HPP
+#define REORDER_BUFFER_HPP
+
+#include <ctime>
+#include <vector>
+
+#include <util/ring_buffer.hpp>
+
+// Puts the linkpacks of an approximately sorted input back in the order of
+// their timestamps. A linkpack is held until the input has reached a time
+// later than its own by the lateness, so that the linkpacks arriving late
+// by at most the lateness are given in their place. Linkpacks later than
+// that cannot be given in order any more and are dropped. The linkpacks
+// arriving in order are kept in a queue, only the late ones go through a
+// heap, so that a sorted input costs O(1) per linkpack. Linkpacks with the
+// same timestamp keep their order of arrival.
+
+class reorder_buffer {
+public:
+   reorder_buffer(long lateness)
+      : lateness(lateness), seq(0), started(false), dropped(0) { }
+
+   // returns false if the linkpack was dropped
+   bool push(const std::vector <unsigned> &linkpack, double weight,
+         time_t time);
+
+   // gives the earliest linkpack once it is ready, or at the end of the
+   // input any linkpack left; returns false if there is none
+   bool pop(std::vector <unsigned> &linkpack, double &weight, time_t &time,
+         bool end);
+
+   bool empty() const { return inorder.empty() && late.empty(); }
+   // calls f with the ids of all the linkpacks held
+   template <class F>
+   void for_each_id(F f) const {
+      for (size_t i=0; i<inorder.size(); i++)
+         for (size_t k=0; k<inorder[i].ids.size(); k++) f(inorder[i].ids[k]);
+      for (size_t i=0; i<late.size(); i++)
+         for (size_t k=0; k<late[i].ids.size(); k++) f(late[i].ids[k]);
+   }
+   unsigned long get_dropped() const { return dropped; }
+
+private:
+   struct record {
+      time_t time;
+      unsigned long seq;
+      double weight;
+      std::vector <unsigned> ids;
+   };
+   // the heap keeps the earliest record on its top
+   struct later {
+      bool operator() (const record &a, const record &b) const {
+         return a.time>b.time || (a.time==b.time && a.seq>b.seq);
+      }
+   };
+
+   const long lateness;
+   unsigned long seq;
+   bool started; // a linkpack was given, its time is the last one
+   time_t last; // time of the last linkpack given
+   time_t latest; // latest time pushed
+   unsigned long dropped;
+   ring_buffer <record> inorder;
+   std::vector <record> late;
+};
+
+#endif
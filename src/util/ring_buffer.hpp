@@ -0,0 +1,53 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <vector>
+
+// Growable first-in first-out buffer kept in one contiguous block. The
+// capacity is a power of two and doubles when the buffer is full, so that
+// appending at the back and dropping from the front are O(1) amortised.
+// Elements are indexed from the oldest one.
+
+template <class T>
+class ring_buffer {
+public:
+   ring_buffer() : store(16), head(0), count(0) { }
+
+   bool empty() const { return count==0; }
+   size_t size() const { return count; }
+   size_t capacity() const { return store.size(); }
+
+   T& operator[](size_t i) { return store[(head+i)&(store.size()-1)]; }
+   const T& operator[](size_t i) const {
+      return store[(head+i)&(store.size()-1)];
+   }
+   T& front() { return store[head]; }
+   T& back() { return (*this)[count-1]; }
+
+   void push_back(const T &element) {
+      if (count==store.size()) grow();
+      store[(head+count)&(store.size()-1)] = element;
+      count++;
+   }
+
+   // drops n oldest elements
+   void pop_front(size_t n=1) {
+      head = (head+n)&(store.size()-1);
+      count -= n;
+   }
+
+   void clear() { head = 0; count = 0; }
+
+private:
+   void grow() {
+      std::vector <T> larger(2*store.size());
+      for (size_t i=0; i<count; i++) larger[i] = (*this)[i];
+      store.swap(larger);
+      head = 0;
+   }
+
+   std::vector <T> store;
+   size_t head, count;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Bounded queue between one producer thread and one consumer thread. The
+// elements are slots of a fixed ring that are filled and read in place,
+// so that elements holding vectors keep their capacity from one round to
+// the next. The positions are published with release stores and read with
+// acquire loads, so everything written into a slot, and everything the
+// producer wrote before it, is visible to the consumer once it gets the
+// slot. A waiting side spins shortly, then yields, then sleeps.
+// Either side may close the ring, which wakes up the other side.
+
+template <class T>
+class spsc_ring {
+public:
+   // the capacity is rounded up to a power of two
+   explicit spsc_ring(size_t capacity) : head(0), tail(0), closed(false) {
+      size_t size = 2;
+      while (size<capacity) size *= 2;
+      slots.resize(size);
+   }
+
+   // producer side: waits for a free slot, returns 0 if the ring is closed
+   T* acquire() {
+      size_t t = tail.load(std::memory_order_relaxed);
+      for (unsigned tries=0; ; tries++) {
+         if (closed.load(std::memory_order_acquire)) return 0;
+         if (t-head.load(std::memory_order_acquire)<slots.size())
+            return &slots[t&(slots.size()-1)];
+         wait(tries);
+      }
+   }
+   // producer side: hands the acquired slot to the consumer
+   void publish() {
+      tail.store(tail.load(std::memory_order_relaxed)+1,
+         std::memory_order_release);
+   }
+
+   // consumer side: waits for a published slot, returns 0 if the ring is
+   // closed and all the published slots were released
+   T* front() {
+      return front_until(std::chrono::steady_clock::time_point::max());
+   }
+   // consumer side: as front(), but returns 0 also at the deadline
+   T* front_until(const std::chrono::steady_clock::time_point &deadline) {
+      for (unsigned tries=0; ; tries++) {
+         T *slot = peek();
+         if (slot) return slot;
+         if (closed.load(std::memory_order_acquire)) return peek();
+         if ((tries&63)==63 && std::chrono::steady_clock::now()>=deadline)
+            return 0;
+         wait(tries);
+      }
+   }
+   // consumer side: the published slot if there is one, without waiting
+   T* peek() {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (tail.load(std::memory_order_acquire)==h) return 0;
+      return &slots[h&(slots.size()-1)];
+   }
+   // consumer side: gives the slot of front() back to the producer
+   void release() {
+      head.store(head.load(std::memory_order_relaxed)+1,
+         std::memory_order_release);
+   }
+
+   void close() { closed.store(true, std::memory_order_release); }
+   bool is_closed() const { return closed.load(std::memory_order_acquire); }
+
+private:
+   spsc_ring(const spsc_ring &);
+   spsc_ring& operator=(const spsc_ring &);
+
+   // spinning only makes sense when the other side runs on another core
+   static void wait(unsigned tries) {
+      static const bool multicore = std::thread::hardware_concurrency()>1;
+      if (multicore && tries<64) return;
+      if (tries<128) std::this_thread::yield();
+      else std::this_thread::sleep_for(std::chrono::microseconds(100));
+   }
+
+   std::vector <T> slots;
+   // the positions only grow, they are kept apart to avoid false sharing
+   alignas(64) std::atomic <size_t> head;
+   alignas(64) std::atomic <size_t> tail;
+   alignas(64) std::atomic <bool> closed;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "stream_input.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+
+stream_input::stream_input(const string &path, bool follow)
+   : fd(path=="-" ? 0 : open(path.c_str(), O_RDONLY)), follow(follow) {
+   if (fd<0) return;
+   start();
+}
+
+stream_input::~stream_input() {
+   stop();
+   if (fd>0) ::close(fd);
+}
+
+long stream_input::read_chunk(char *data, size_t size) {
+   while (!stopping()) {
+      // the input is waited for in slices, so that the closing is seen
+      pollfd p;
+      p.fd = fd;
+      p.events = POLLIN;
+      int polled = poll(&p, 1, 100);
+      if (polled<0 && errno!=EINTR) return -1;
+      if (polled<=0) continue;
+      ssize_t got = ::read(fd, data, size);
+      if (got>0) return got;
+      if (got<0 && errno==EINTR) continue;
+      if (got<0) return -1;
+      if (!follow) return 0;
+      this_thread::sleep_for(chrono::milliseconds(100));
+   }
+   return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef STREAM_INPUT_HPP
+#define STREAM_INPUT_HPP
+
+#include <string>
+
+#include <util/chunked_input.hpp>
+
+// Reads a stream that may be unbounded, such as the standard input, a
+// named pipe or a file that keeps growing, in a separate thread. Each
+// chunk holds what was available, so that the data reaches the reader as
+// soon as it arrives. A followed input does not end at its end of file,
+// its end is polled until new data arrives.
+
+class stream_input : public chunked_input {
+public:
+   // the path - stands for the standard input
+   stream_input(const std::string &path, bool follow);
+   ~stream_input();
+
+   bool is_open() const { return fd>=0; }
+
+protected:
+   virtual long read_chunk(char *data, size_t size);
+
+private:
+   int fd;
+   bool follow;
+};
+
+#endif
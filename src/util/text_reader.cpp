@@ -0,0 +1,134 @@
+#include "text_reader.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+static inline bool is_blank(char c) {
+   return c==' ' || c=='\t' || c=='\r' || c=='\v' || c=='\f';
+}
+
+const char* parse_long(const char *begin, const char *end, long &value) {
+   const char *p = begin;
+   bool negative = false;
+   if (p<end && (*p=='-' || *p=='+')) negative = (*p++=='-');
+   const char *digits = p;
+   unsigned long result = 0;
+   while (p<end && *p>='0' && *p<='9') result = 10*result+(*p++-'0');
+   if (p==digits) return begin;
+   value = negative ? -(long)result : (long)result;
+   return p;
+}
+
+// a decimal number whose mantissa fits in 53 bits and whose power of ten
+// is at most 22 is computed with a single correctly rounded operation,
+// other numbers are left to strtod
+const char* parse_double(const char *begin, const char *end, double &value) {
+   static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+      1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+      1e20, 1e21, 1e22 };
+   const char *p = begin;
+   bool negative = false;
+   if (p<end && (*p=='-' || *p=='+')) negative = (*p++=='-');
+
+   unsigned long long mantissa = 0;
+   int digits = 0, exponent = 0;
+   bool anydigit = false;
+   while (p<end && *p>='0' && *p<='9') {
+      anydigit = true;
+      if (digits<19) { mantissa = 10*mantissa+(*p-'0'); if (mantissa) digits++; }
+      else exponent++;
+      p++;
+   }
+   if (p<end && *p=='.') {
+      p++;
+      while (p<end && *p>='0' && *p<='9') {
+         anydigit = true;
+         if (digits<19) {
+            mantissa = 10*mantissa+(*p-'0');
+            if (mantissa) digits++;
+            exponent--;
+         }
+         p++;
+      }
+   }
+   if (anydigit && p<end && (*p=='e' || *p=='E')) {
+      long e;
+      const char *after = parse_long(p+1, end, e);
+      if (after!=p+1) { exponent += e; p = after; }
+   }
+
+   if (anydigit && mantissa<(1ull<<53) && exponent>=-22 && exponent<=22) {
+      double result = (double)mantissa;
+      if (exponent<0) result /= powers[-exponent];
+      else result *= powers[exponent];
+      value = negative ? -result : result;
+      return p;
+   }
+
+   // inf, nan, long mantissas and large exponents
+   char copy[128];
+   size_t n = 0;
+   while (begin+n<end && n<sizeof(copy)-1 && !is_blank(begin[n])) n++;
+   memcpy(copy, begin, n);
+   copy[n] = 0;
+   char *after;
+   double result = strtod(copy, &after);
+   if (after==copy) return begin;
+   value = result;
+   return begin+(after-copy);
+}
+
+bool text_reader::next(vector <unsigned> &linkpack, double &weight,
+      time_t &time) {
+   while (pos>=end) if (!source || !source->refill(pos, end)) return false;
+   const char *eol = (const char*)memchr(pos, '\n', end-pos);
+   while (!eol && source) {
+      size_t searched = end-pos;
+      if (!source->refill(pos, end)) break;
+      eol = (const char*)memchr(pos+searched, '\n', end-pos-searched);
+   }
+   if (!eol) eol = end;
+   lines++;
+   if (!parse(pos, eol, linkpack, weight, time)) malformed++;
+   pos = eol<end ? eol+1 : end;
+   return true;
+}
+
+bool text_reader::parse(const char *begin, const char *end,
+      vector <unsigned> &linkpack, double &weight, time_t &time) {
+   linkpack.clear();
+   const char *p = begin;
+   while (p<end && is_blank(*p)) p++;
+   long ts;
+   const char *after = parse_long(p, end, ts);
+   if (after==p) return false;
+   time = ts;
+   p = after;
+
+   // in the weighted format the last token is the weight, so each token
+   // is interned only once the next one has been found
+   const char *last = 0, *lastend = 0;
+   while (true) {
+      while (p<end && is_blank(*p)) p++;
+      if (p==end) break;
+      const char *token = p;
+      while (p<end && !is_blank(*p)) p++;
+      if (weighted) {
+         if (last) linkpack.push_back(nodenames.intern(last, lastend-last));
+         last = token;
+         lastend = p;
+      }
+      else linkpack.push_back(nodenames.intern(token, p-token));
+   }
+   if (weighted) {
+      weight = 0;
+      if (last) parse_double(last, lastend, weight);
+   }
+
+   sort(linkpack.begin(), linkpack.end());
+   linkpack.erase(unique(linkpack.begin(), linkpack.end()), linkpack.end());
+   return true;
+}
@@ -0,0 +1,54 @@
+#ifndef TEXT_READER_HPP
+#define TEXT_READER_HPP
+
+#include <ctime>
+#include <vector>
+
+#include <util/input_source.hpp>
+#include <util/link_reader.hpp>
+#include <util/name_table.hpp>
+
+// Reads linkpacks from the lines of a dynamic network in the text formats:
+//    sdnet: timestamp node1 node2 ...
+//    wdnet: timestamp node1 node2 ... weight
+// The lines are tokenised in place and the node names are interned
+// directly from the input, so that reading a line does not allocate
+// once the names are known. The linkpack holds sorted unique ids.
+
+class text_reader : public link_reader {
+public:
+   // reads the text between begin and end, followed by the chunks of the
+   // source if one is given
+   text_reader(const char *begin, const char *end, bool weighted,
+         name_table &nodenames, input_source *source=0)
+      : pos(begin), end(end), source(source), weighted(weighted),
+        nodenames(nodenames), lines(0), malformed(0) { }
+
+   // reads the next line, returns false at the end of the input; a line
+   // without a timestamp gives an empty linkpack and keeps the time
+   virtual bool next(std::vector <unsigned> &linkpack, double &weight,
+         time_t &time);
+
+   // parses a single line without its end of line character
+   bool parse(const char *begin, const char *end,
+         std::vector <unsigned> &linkpack, double &weight, time_t &time);
+
+   unsigned long get_lines() const { return lines; }
+   virtual bool ready() { return pos<end || !source || source->ready(); }
+   virtual void close() { if (source) source->close(); }
+   virtual unsigned long get_malformed() const { return malformed; }
+
+private:
+   const char *pos, *end;
+   input_source *source;
+   const bool weighted;
+   name_table &nodenames;
+   unsigned long lines, malformed;
+};
+
+// fast parsers of numbers, return the position after the parsed number
+// or begin if there was no number
+const char* parse_long(const char *begin, const char *end, long &value);
+const char* parse_double(const char *begin, const char *end, double &value);
+
+#endif
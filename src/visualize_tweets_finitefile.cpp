@@ -4,7 +4,9 @@
  * subnetwork.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <fstream>
 #include <vector>
 #include <string>
@@ -18,6 +20,13 @@
 #include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/date_time/local_time_adjustor.hpp>
 
+#include <util/async_writer.hpp>
+#include <util/bdnet.hpp>
+#include <util/distinct_counter.hpp>
+#include <util/linkpack_pipeline.hpp>
+#include <util/input_file.hpp>
+#include <util/name_table.hpp>
+#include <util/text_reader.hpp>
 #include <util/time_checker.hpp>
 #include <util/pace_checker.hpp>
 
@@ -26,6 +35,7 @@
 
 #include <viz/client.hpp>
 #include <viz/client_gephi.hpp>
+#include <viz/client_gephi_stream.hpp>
 #include <viz/net_collector.hpp>
 #include <viz/net_collector_timewindow.cpp>
 #include <viz/viz_selector.hpp>
@@ -36,60 +46,14 @@ namespace pt = boost::posix_time;
 //=====================================================================
 // global variable used by signal handler
 //=====================================================================
-bool keep_going = true;
+volatile sig_atomic_t keep_going = 1;
 
 void handle_kill(int sig) {
-   keep_going = false;
+   keep_going = 0;
    // unregister myself
    signal(SIGINT, SIG_DFL);
 }
 
-//=====================================================================
-// loads a pack of links from a line of file
-//=====================================================================
-void get_linkpack( const char *bufch,
-                   vector <string> &linkpack, time_t &time ) {
-   istringstream bufis(bufch);
-   bufis>>time;
-   if (!bufis.good()) return;
-   string node;
-
-   // to assure no unique, also in case last field read twice
-   set<string> unique;
-   while (bufis.good()) {
-      bufis>>node;
-      unique.insert(node);
-   }
-   linkpack.assign(unique.begin(),unique.end());
-
-   // debugging
-   // cout<<"Line: "<<bufch<<endl;
-   // if (linkpack.size()<2) {
-   //    cout<<"Line: "<<bufch<<endl;
-   //    cout<<" has has less than 3 collumns, skipping the line..."<<endl;
-   // }
-}
-
-void get_weighted_linkpack( const char *bufch,
-                   vector <string> &linkpack, double &weight, time_t &time ) {
-   istringstream bufis(bufch);
-   bufis>>time;
-   if (!bufis.good()) return;
-   string node;
-
-   // to assure no unique, also in case last field read twice
-   set<string> unique;
-   bufis>>node;
-   while (bufis.good()) {
-      unique.insert(node);
-      bufis>>node;
-   }
-   weight = atof(node.c_str());
-   linkpack.assign(unique.begin(),unique.end());
-
-}
-
-
 //=====================================================================
 // the main function, reads sequentially lines of the input files
 // output differential network files
@@ -98,14 +62,19 @@ void get_weighted_linkpack( const char *bufch,
 //=====================================================================
 
 int do_filter( int verbose, string viztype,
-               string input, string inputformat,
-               string output, string server,
+               string input, string inputformat, bool follow,
+               unsigned lateness,
+               string output, string server, unsigned serverbatch,
+               unsigned serverretries, unsigned outputqueue,
+               async_writer::policy_type outputpolicy, string outputpolicyname,
                const unsigned maxstored, const unsigned maxvisualized,
-               unsigned forgetevery, double forgetconst,
-               double timewindow, double edgemin,
+               unsigned forgetevery, double forgetconst, string forgetmode,
+               double timewindow, unsigned windowmemory,
+               double decaytolerance, double edgemin, double changetolerance,
                string label1, string label2, string label3,
                string hidden_node, bool hide_singletons,
-               unsigned timecontraction, unsigned fps
+               unsigned timecontraction, unsigned fps, unsigned statsevery,
+               bool exactcounts
                ) {
    // system signals handlers
    signal(SIGINT, handle_kill);
@@ -113,20 +82,34 @@ int do_filter( int verbose, string viztype,
    //=====================================================================
    // load data
    //=====================================================================
-   vector <string> linkpack;
+   vector <unsigned> linkpack;
    double weight = 1;
-   time_t linktime, prev_linktime;
-   set <string> all_nodes; // used solely for gathering additional statistics
+   time_t linktime;
 
-   ifstream inputnet(input.c_str());
-   {
-      static char bufch[100000];
-      inputnet.getline(bufch,100000);
-      if (inputformat=="weighted")
-         get_weighted_linkpack(bufch, linkpack, weight, linktime);
-      else
-         get_linkpack(bufch, linkpack, linktime);
+   input_file inputfile(input, follow);
+   // a stream may never end, its frames are also closed by the wall-clock
+   bool streaming = inputfile.is_stream();
+   if (!inputfile.is_open()) {
+      cout<<"Could not open the input file "<<input<<endl;
+      return -1;
+   }
+   // the ids of the nodes that left a stream are given to new names, so
+   // that a stream that never ends is held in bounded memory; bdnet has
+   // all its names in its dictionary
+   bool isbdnet = bdnet_reader::recognizes(inputfile.begin(), inputfile.end());
+   name_table nodenames(streaming && !isbdnet);
+   // used solely for gathering additional statistics
+   distinct_counter all_nodes(exactcounts && !nodenames.recycles());
+
+   unique_ptr <link_reader> inputnet;
+   if (isbdnet) {
+      cout<<"Reading the input in the binary format bdnet."<<endl;
+      inputnet.reset(new bdnet_reader(inputfile.begin(), inputfile.end(),
+         nodenames, inputfile.source()));
    }
+   else inputnet.reset(new text_reader(inputfile.begin(), inputfile.end(),
+      inputformat=="weighted", nodenames, inputfile.source()));
+   inputnet->next(linkpack, weight, linktime);
 
    time_t firstlink_time=linktime;
    long upd_interval=round(1.0*timecontraction/fps);
@@ -142,14 +125,24 @@ int do_filter( int verbose, string viztype,
    cout<<"  viztype: "<<viztype<<endl;
    cout<<"  input: "<<input<<endl;
    cout<<"  inputformat: "<<inputformat<<endl;
+   cout<<"  follow: "<<follow<<endl;
+   cout<<"  lateness: "<<lateness<<endl;
    cout<<"  output: "<<output<<endl;
    cout<<"  server: "<<server<<endl;
+   cout<<"  serverbatch: "<<serverbatch<<endl;
+   cout<<"  serverretries: "<<serverretries<<endl;
+   cout<<"  outputqueue: "<<outputqueue<<endl;
+   cout<<"  outputpolicy: "<<outputpolicyname<<endl;
    cout<<"  maxstored: "<<maxstored<<endl;
    cout<<"  maxvisualized: "<<maxvisualized<<endl;
    cout<<"  forgetevery: "<<forgetevery<<endl;
    cout<<"  forgetconst: "<<forgetconst<<endl;
+   cout<<"  forgetmode: "<<forgetmode<<endl;
    cout<<"  timewindow: "<<timewindow<<endl;
+   cout<<"  windowmemory: "<<windowmemory<<endl;
+   cout<<"  decaytolerance: "<<decaytolerance<<endl;
    cout<<"  edgemin: "<<edgemin<<endl;
+   cout<<"  changetolerance: "<<changetolerance<<endl;
    cout<<"  label1: "<<label1<<endl;
    cout<<"  label2: "<<label2<<endl;
    cout<<"  label3: "<<label3<<endl;
@@ -157,9 +150,18 @@ int do_filter( int verbose, string viztype,
    cout<<"  hide_singletons: "<<hide_singletons<<endl;
    cout<<"  timecontraction: "<<timecontraction<<endl;
    cout<<"  fps: "<<fps<<endl;
+   cout<<"  statsevery: "<<statsevery<<endl;
+   cout<<"  exactcounts: "<<exactcounts<<endl;
+
+   // number of links of the time-window fitting in the memory budget
+   size_t maxlinks=1024*1024/sizeof(link_timed)*windowmemory;
+   if (maxlinks<1) maxlinks=1;
 
    cout<<"Derived:"<<endl;
    cout<<"  interval: "<<upd_interval<<endl;
+   cout<<"  maxlinks: "<<maxlinks<<endl;
+   cout<<"  streaming: "<<streaming<<endl;
+   cout<<"  recycled ids: "<<nodenames.recycles()<<endl;
 
    //=====================================================================
    // time checkers inits
@@ -184,38 +186,72 @@ int do_filter( int verbose, string viztype,
    // selectors and visualizers classes
    //=====================================================================
    client_base *myoutput;
-   if (server!="") myoutput=new client_gephi(server,output);
-   else myoutput=new client_file(output);
+   if (server!="" && serverbatch>0)
+      myoutput=new client_gephi_stream(server,serverbatch,serverretries,
+         outputqueue,outputpolicy,&keep_going);
+   else if (server!="")
+      myoutput=new client_gephi(client_gephi_stream::endpoint(server),output,
+         outputqueue,outputpolicy);
+   else if (bdframes::is_named(output))
+      myoutput=new client_binary(output,outputqueue,outputpolicy);
+   else myoutput=new client_file(output,outputqueue,outputpolicy);
 
    net_collector_base *mynet;
    viz_selector_base *myviz;
 
-   if (viztype=="fastviz")
-      mynet=new net_collector( maxstored, myclockcollector, verbose );
+   if (viztype=="fastviz") {
+      if (forgetmode!="lazy" && forgetmode!="eager") {
+         cout<<"Unrecongized forgetmode specified."<<endl;
+         return -1;
+      }
+      mynet=new net_collector( maxstored, nodenames, myclockcollector, verbose,
+         forgetmode=="lazy" );
+   }
    else if (viztype=="timewindow")
-      mynet=new net_collector_timewindow( maxstored,
-         timewindow,  forgetconst, viztype, myclockcollector, verbose );
+      mynet=new net_collector_timewindow( maxstored, nodenames,
+         timewindow,  forgetconst, viztype, myclockcollector, verbose,
+         maxlinks );
    else if (viztype=="exptimewindow")
-      mynet=new net_collector_timewindow( maxstored,
-         timewindow, forgetconst, viztype, myclockcollector, verbose );
+      mynet=new net_collector_timewindow( maxstored, nodenames,
+         timewindow, forgetconst, viztype, myclockcollector, verbose,
+         maxlinks, decaytolerance );
    else {
       cout<<"Unrecongized viztype specified."<<endl;
       return -1;
    }
 
-   myviz=new viz_selector( *mynet, *myoutput, myclockcollector, verbose );
+   // the statistics of the buffered network are kept up to date when they
+   // are printed for every frame, and computed when printed otherwise
+   bool everyframe = verbose>2 || (verbose>0 && statsevery==1);
+   myviz=new viz_selector( *mynet, *myoutput, myclockcollector, verbose,
+      changetolerance, everyframe, exactcounts );
 
    if (server=="")
       myviz->add_labels( pt::to_simple_string(pt::from_time_t(linktime)),
                         label1, label2, label3 );
 
-   ofstream ostream_buf( (output+"_buf.nodes").c_str() );
-   ofstream ostream_viz( (output+"_vis.nodes").c_str() );
+   unsigned hidden_id = name_table::npos;
+   if (hidden_node!="") hidden_id = nodenames.intern(hidden_node);
+
+   string outputbase = bdframes::base_name(output);
+   ofstream ostream_buf( (outputbase+"_buf.nodes").c_str() );
+   ofstream ostream_viz( (outputbase+"_vis.nodes").c_str() );
+
+   // from now on the names are interned by the reader thread only
+   linkpack_pipeline pipeline(*inputnet, linkpack, weight, linktime,
+      upd_interval, streaming, lateness, nodenames);
+
+   // the unused ids are given back once at least as many names were added
+   // as the collector holds nodes, so that the table holds about twice
+   // the nodes held; the sweep costs then O(1) per name added
+   const unsigned long minrecycled = 1<<16;
+   unsigned long givenback = 0;
+   vector <unsigned> unused;
 
    //=====================================================================
    // time to start
    //=====================================================================
-   long total_read = 0, total_links = 0, total_malformed = 0;
+   long total_read = 0, total_links = 0;
    double total_score;
    int line=1, frame=0;
    long ts;
@@ -225,12 +261,17 @@ int do_filter( int verbose, string viztype,
       // printf("%d %d\n",ts,linktime); cout.flush();
       frame++;
 
-      if (!inputnet.good()) {
-         keep_going=0;
-         cout<<"The file has finished (0), last line number is "<<line<<endl;
-      }
-
-      while ( keep_going && linktime>=ts && linktime<ts+upd_interval )
+      // an idle stream still gets a frame for each interval of its time,
+      // taken as seconds of the wall-clock
+      linkpack_pipeline::time_point deadline =
+         linkpack_pipeline::time_point::max();
+      if (streaming)
+         deadline = std::chrono::steady_clock::now()
+            + std::chrono::seconds(upd_interval);
+
+      while ( keep_going
+            && pipeline.next(frame, linkpack, weight, linktime, deadline,
+                  &keep_going) )
       {
          ++total_read;
 
@@ -250,9 +291,9 @@ int do_filter( int verbose, string viztype,
                mynet->add_linkpack( linkpack, weight, linktime, verbose );
             }
          }
-         if (verbose>1) {
-            all_nodes.insert( linkpack.begin(), linkpack.end() );
-         }
+         if (verbose>0)
+            for (unsigned i=0; i<linkpack.size(); i++)
+               all_nodes.insert( nodenames.key(linkpack[i]) );
 
          //=====================================================================
          // print stats
@@ -267,64 +308,73 @@ int do_filter( int verbose, string viztype,
                   << "lines read: " << total_read << endl
                   << "links encountered: " << total_links << "(" << (double(total_links) / total_read)
                   << ")" << endl
-                  << "malformed: " << total_malformed << endl;
+                  << "malformed: " << pipeline.get_malformed() << endl
+                  << "dropped as too late: " << pipeline.get_dropped() << endl;
          }
 
-         //=====================================================================
-         // link reading
-         //=====================================================================
-         {static char bufch[100000];
          line++;
-         if (!inputnet.getline(bufch,100000)) {
-            keep_going=0;
-            cout<<"The file has finished (1), last line number is "<<line<<endl;
-            break;
-         }
-         if (!inputnet.good()) {
-            keep_going=0;
-            cout<<"The file has finished (2), last line number is "<<line<<endl;
-         }
-         linkpack.clear();
-         prev_linktime=linktime;
-         if (inputformat=="weighted")
-            get_weighted_linkpack(bufch, linkpack, weight, linktime);
-         else
-            get_linkpack(bufch, linkpack, linktime);
-         if (prev_linktime>linktime) {
-            cout<<"Data is not sorted in increasing order of the timestamps, exiting."
-                <<endl;
-            keep_going=0;
-         }}
+      }
+
+      //=====================================================================
+      // end of the input
+      //=====================================================================
+      if (pipeline.unsorted()) {
+         cout<<"Data is not sorted in increasing order of the timestamps, exiting."
+             <<endl;
+         keep_going=0;
+      }
+      else if (pipeline.finished()) {
+         keep_going=0;
+         if (inputfile.failed())
+            cout<<"The decompression of the file has failed, it was read up to the error."<<endl;
+         cout<<"The file has finished (1), last line number is "<<line<<endl;
       }
 
       //=====================================================================
       // visualize selected set of nodes (creates data for a frame)
       //=====================================================================
-      if (server=="")
+      // a frame dropped while the output is behind is not made, the next
+      // one made carries its changes; the last frame is always made
+      bool dropped = keep_going && myoutput->drop_frame();
+      if (server=="" && !dropped)
          myviz->change_label_datetime(
             pt::to_simple_string(pt::from_time_t(long(ts))));
 
       // update adjeciency matric if needed and draw
       mynet->update_net_collector_base( );
-      myviz->draw(maxvisualized, edgemin, hidden_node, hide_singletons);
+      if (!dropped)
+         myviz->draw(maxvisualized, edgemin, hidden_id, hide_singletons);
+
+      // the drawn nodes are held by the collector, the hidden one is kept;
+      // after a dropped frame the output may still show nodes that left it
+      if (!dropped && nodenames.recycles() && pipeline.get_added()-givenback >=
+            max<unsigned long>(minrecycled, mynet->get_nodes_number())) {
+         unused.clear();
+         mynet->get_unused_ids(unused);
+         unused.erase( remove(unused.begin(), unused.end(), hidden_id),
+            unused.end() );
+         pipeline.release(unused);
+         givenback = pipeline.get_added();
+      }
 
       // debugging
       if (verbose>3) {
          cout<<"mynet network (limited to 10x10 matrix):"<<endl;
-         for (int i=0; i<10; i++) cout<<mynet->names[i]<<" ";
+         for (int i=0; i<10; i++) if (mynet->ids[i]!=name_table::npos)
+            cout<<nodenames.c_str(mynet->ids[i])<<" ";
          cout<<endl;
          for (int i=0; i<10; i++) {
             for (int j=0; j<10; j++)
-               cout<<mynet->net[i][j]<<" ";
+               cout<<mynet->net.get(i,j)<<" ";
             cout<<endl;
          }
       }
 
       // output additional statistics
-      if ( (verbose>0 && frame%30==0) || verbose>2 ) {
+      if ( (verbose>0 && frame%statsevery==0) || verbose>2 ) {
          mynet->print_nodes( ostream_buf );
          myviz->print_visualized_nodes( ostream_viz );
-         auto nodes_encountered = all_nodes.size();
+         auto nodes_encountered = all_nodes.count();
          auto score_encountered = total_score;
          auto nodes_buffered = mynet->get_nodes_number();
          auto score_buffered = mynet->get_total_score();
@@ -332,15 +382,16 @@ int do_filter( int verbose, string viztype,
          auto score_visualized = myviz->get_total_score();
          auto nodes_hidden = myviz->get_nodes_not_visualized();
          char netsstats[400]; myviz->get_netsstats(netsstats);
+         char outputstats[200]; myoutput->get_outputstats(outputstats);
          printf("Frame stats:"
-            "nodes_encountered=%6d, score_encountered=%6.0f, "
+            "nodes_encountered=%6lu, score_encountered=%6.0f, "
             "nodes_buffered=%6d, score_buffered=%6.0f, "
             "nodes_visualized=%6d, score_visualized=%6.0f, "
-            "nodes_hidden=%6d, %s.\n",
+            "nodes_hidden=%6d, %s, %s.\n",
             nodes_encountered, score_encountered,
             nodes_buffered, score_buffered,
             nodes_visualized, score_visualized,
-            nodes_hidden, netsstats );
+            nodes_hidden, netsstats, outputstats );
       }
 
       //=====================================================================
@@ -370,15 +421,25 @@ int do_filter( int verbose, string viztype,
    cout<<"Total lines read: "<<total_read
        <<", links loaded: "<<total_links
        <<", frames generated: "<<frame<<endl;
-   if (verbose>0)
-      cout<<"Total nodes encountered: "<<all_nodes.size()
+   if (pipeline.get_dropped()>0)
+      cout<<"Lines dropped as later than the lateness: "
+          <<pipeline.get_dropped()<<endl;
+   if (verbose>0) {
+      cout<<"Total nodes encountered: "<<all_nodes.count()
           <<", total nodes drawn: "<<myviz->get_how_many_drawn()<<endl;
+      char outputtotals[200]; myoutput->get_outputtotals(outputtotals);
+      cout<<"Output "<<outputtotals<<endl;
+   }
 
    if (verbose>4) {
       myclockcollector.printall();
       myclockcollector.resetall();
    }
 
+   // the frames waiting are written, the binary output ends with the
+   // index of its frames
+   delete myoutput;
+
    return total_links;
 }
 
@@ -396,22 +457,66 @@ int main(int argc, char** argv) {
       ("verbose", po::value<int>()->default_value(1), "")
       ("viztype", po::value<string>()->default_value("fastviz"),
          "Possible visualization types: fastviz (default), timewindow")
-      ("input", po::value<string>()->default_value(""),"")
-      ("inputformat", po::value<string>()->default_value(""),"")
-      ("output", po::value<string>()->default_value(""), "")
+      ("input", po::value<string>()->default_value(""),
+         "Files ending with .gz are decompressed while they are read. "
+         "The standard input (-) and named pipes are read as streams, "
+         "whose frames are also closed after each interval of their time "
+         "passes on the wall-clock, so that an idle stream still gets "
+         "frames.")
+      ("follow", po::value<bool>()->default_value(false),
+         "Read the input as a stream that keeps growing, like tail -f.")
+      ("lateness", po::value<unsigned>()->default_value(0),
+         "Lines whose timestamps are late by at most this many seconds are "
+         "put back in order, later ones are dropped. With 0 a file that is "
+         "not sorted ends at the first late line, a stream drops it.")
+      ("inputformat", po::value<string>()->default_value(""),
+         "weighted for the wdnet format, files in the binary format bdnet "
+         "are recognized without it.")
+      ("output", po::value<string>()->default_value(""),
+         "The events are written to the file with the suffix .json added, "
+         "or in the binary format bdframes when the name ends with "
+         ".bdframes.")
       ("server", po::value<string>()->default_value(""),
          "Address to the updateGraph command of Gephi Streaming API server."
          "If not provided then output is printed to file pointed as argument"
-         "of --output option.")
+         "of --output option. An address without a path, such as "
+         "http://localhost, stands for workspace0 of Gephi on port 8080 "
+         "unless an other port is given.")
+      ("serverbatch", po::value<unsigned>()->default_value(30),
+         "Number of frames sent in each request over the connection kept "
+         "open to the server, which acknowledges them together; the frames "
+         "not acknowledged are sent again on a new connection. 0 posts each "
+         "frame on a new connection.")
+      ("serverretries", po::value<unsigned>()->default_value(0),
+         "Number of tries to send the frames to the server before they are "
+         "given up, 0 tries for ever; at the end or after Ctrl-C they are "
+         "tried at most 3 times.")
       ("maxstored", po::value<unsigned>()->default_value(2000), "")
       ("maxvisualized", po::value<unsigned>()->default_value(50), "")
       ("forgetevery", po::value<unsigned>()->default_value(10),
          "Influences only the fastviz algorithm.")
       ("forgetconst", po::value<double>()->default_value(0.75),
          "Influences only the fastviz algorithm.")
+      ("forgetmode", po::value<string>()->default_value("lazy"),
+         "Influences only the fastviz algorithm. Possible modes: "
+         "lazy (default) scales all weights at once through their shared unit, "
+         "eager multiplies every stored weight.")
       ("timewindow", po::value<double>()->default_value(2000),
          "Influences only the timewindow algorithm.")
+      ("windowmemory", po::value<unsigned>()->default_value(24),
+         "Influences only the timewindow algorithms. Memory budget in MB "
+         "for the links of the time-window, the oldest links are dropped "
+         "when it is exceeded.")
+      ("decaytolerance", po::value<double>()->default_value(1e-6),
+         "Influences only the exptimewindow algorithm. Links leave the "
+         "time-window when their weight decays below the tolerance times "
+         "their original weight, which is below 1; 0 keeps them within the "
+         "memory budget.")
       ("edgemin", po::value<double>()->default_value(0.95), "")
+      ("changetolerance", po::value<double>()->default_value(0.05),
+         "Node sizes and edge weights are sent again only when they change "
+         "by more than this fraction of the value sent, 0 sends every "
+         "change.")
       ("label1", po::value<string>()->default_value(""),"")
       ("label2", po::value<string>()->default_value(""),"")
       ("label3", po::value<string>()->default_value(""),"")
@@ -421,6 +526,22 @@ int main(int argc, char** argv) {
          "Hide nodes without edges in the visualization")
       ("timecontraction", po::value<unsigned>()->default_value(3600), "")
       ("fps", po::value<unsigned>()->default_value(30), "")
+      ("outputqueue", po::value<unsigned>()->default_value(2),
+         "Number of frames waiting for the thread writing the output, so "
+         "that a slow disk or server does not stall the input; 0 writes "
+         "them in the main thread.")
+      ("outputpolicy", po::value<string>()->default_value("block"),
+         "What to do when the output queue is full: block waits for the "
+         "writer, drop skips the frame (the next frame carries its "
+         "changes), coalesce writes the frame together with the last one "
+         "waiting, up to 8 MB, then blocks.")
+      ("statsevery", po::value<unsigned>()->default_value(30),
+         "Number of frames between the statistics printed with verbose 1 "
+         "or 2, 1 prints them for every frame.")
+      ("exactcounts", po::value<bool>()->default_value(false),
+         "Count exactly the nodes encountered and drawn, instead of "
+         "estimating them in constant memory within about 1%; a stream "
+         "is always estimated.")
       ;
 
    po::variables_map vm;
@@ -437,6 +558,8 @@ int main(int argc, char** argv) {
 
    string input = vm["input"].as<string>();
    string inputformat = vm["inputformat"].as<string>();
+   bool follow = vm["follow"].as<bool>();
+   unsigned lateness = vm["lateness"].as<unsigned>();
    string output = vm["output"].as<string>();
    string server = vm["server"].as<string>();
    if ( input=="" || (output=="" && server=="") ) {
@@ -445,15 +568,35 @@ int main(int argc, char** argv) {
       exit(1);
    }
    if (server!="") cout<<"Data will be sent to: "<<server<<endl;
+   else if (bdframes::is_named(output))
+      cout<<"Data will be saved to file: "<<output<<endl;
    else cout<<"Data will be saved to file: "<<output<<".json"<<endl;
+   unsigned serverbatch = vm["serverbatch"].as<unsigned>();
+   unsigned serverretries = vm["serverretries"].as<unsigned>();
+   unsigned outputqueue = vm["outputqueue"].as<unsigned>();
+   string outputpolicyname = vm["outputpolicy"].as<string>();
+   async_writer::policy_type outputpolicy;
+   if (!async_writer::parse_policy(outputpolicyname, outputpolicy)) {
+      cout<<"The output policy is one of block, drop and coalesce."<<endl;
+      exit(1);
+   }
 
    unsigned maxstored = vm["maxstored"].as<unsigned>();
    unsigned maxvisualized = vm["maxvisualized"].as<unsigned>();
    unsigned forgetevery = vm["forgetevery"].as<unsigned>();
    if (viztype!="fastviz") forgetevery=0;
    double forgetconst = vm["forgetconst"].as<double>();
+   string forgetmode = vm["forgetmode"].as<string>();
    double timewindow = vm["timewindow"].as<double>();
+   unsigned windowmemory = vm["windowmemory"].as<unsigned>();
+   double decaytolerance = vm["decaytolerance"].as<double>();
+   // a tolerance of 1 or more would put the horizon before the links
+   if (decaytolerance<0 || decaytolerance>=1) {
+      cout<<"The decaytolerance is 0 or between 0 and 1."<<endl;
+      exit(1);
+   }
    double edgemin = vm["edgemin"].as<double>();
+   double changetolerance = vm["changetolerance"].as<double>();
    string label1 = vm["label1"].as<string>();
    string label2 = vm["label2"].as<string>();
    string label3 = vm["label3"].as<string>();
@@ -461,13 +604,20 @@ int main(int argc, char** argv) {
    bool hide_singletons = vm["hide_singletons"].as<bool>();
    unsigned timecontraction = vm["timecontraction"].as<unsigned>();
    unsigned fps = vm["fps"].as<unsigned>();
+   unsigned statsevery = max(1u, vm["statsevery"].as<unsigned>());
+   bool exactcounts = vm["exactcounts"].as<bool>();
 
-   do_filter( verbose, viztype, input, inputformat, output, server,
+   do_filter( verbose, viztype, input, inputformat, follow, lateness,
+              output, server, serverbatch, serverretries,
+              outputqueue, outputpolicy, outputpolicyname,
               maxstored, maxvisualized,
-              forgetevery, forgetconst, timewindow, edgemin,
+              forgetevery, forgetconst, forgetmode,
+              timewindow, windowmemory, decaytolerance, edgemin,
+              changetolerance,
               label1, label2, label3,
               hidden_node, hide_singletons,
-              timecontraction, fps
+              timecontraction, fps, statsevery,
+              exactcounts
               );
    return 0;
 }
@@ -0,0 +1,398 @@
+/*
+ * Binary differential frames, a compact form of the events that
+ * client_file writes as JSON
+ *
+ * All integers are little-endian, varints use 7 bits per byte with the
+ * lowest group first and the signed ones are zigzag encoded.
+ *
+ *    header   "bdfrm\0\0\1"
+ *    records  u32 length of the events shifted left by one bit, set when
+ *             the record ends its frame, followed by the events; a frame
+ *             is written in several records when it is large
+ *    index    u32 0xffffffff, u64 number of frames, u64 offset of the
+ *             first record of each frame, u64 offset of the index and
+ *             "bdfrmidx", which end the file; the index is written when
+ *             the output is closed
+ *
+ * An event is a byte with the code of its type, in the order of the
+ * types below, plus 16 when its id is a number; its id, as a string or as
+ * the varint difference to the previous numeric id; a varint number of
+ * attributes and the attributes.
+ *
+ * A string is a varint v: an even v refers to the entry v>>1 of the
+ * dictionary, otherwise v>>2 bytes follow, which become the next entry of
+ * the dictionary unless v&2 is set. The ids of the events and the
+ * sources and targets of the edges enter the dictionary, the other
+ * strings only refer to it when they are already there.
+ *
+ * An attribute is a varint name<<3 | kind, name being the index of its
+ * name among the names of the attributes, which are defined once by the
+ * kind 7 followed by a varint length and the bytes of the name. Kinds
+ * 0 and 1 are the values false and true, 2 and 3 a signed and an unsigned
+ * varint, 4 a byte q for the number q/255, 5 a 32-bit float and 6 a
+ * string. Integral numbers take the kind 2 and the numbers that are
+ * exact multiples of 1/255 between 0 and 1, like the colours, the kind 4,
+ * so that both give back the same JSON; the other numbers are kept to the
+ * 7 significant digits of the float.
+ */
+
+#ifndef VIZ_BDFRAMES_HPP
+#define VIZ_BDFRAMES_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include <util/name_table.hpp>
+#include <viz/json_events.hpp>
+
+using namespace std;
+
+class bdframes {
+public:
+   static const unsigned types = 9;
+
+   static const char* type_name (unsigned code) {
+      static const char *names[types] =
+         {"an", "cn", "dn", "ae", "ce", "de", "al", "cl", "dl"};
+      return names[code];
+   }
+
+   // the file name of an output in this format
+   static bool is_named (const string &name) {
+      return name.size()>=suffixlen
+         && !name.compare(name.size()-suffixlen, suffixlen, ".bdframes");
+   }
+
+   // the output name without the suffix of the format
+   static string base_name (const string &name) {
+      return is_named(name) ? name.substr(0, name.size()-suffixlen) : name;
+   }
+
+protected:
+   static const size_t suffixlen = 9;
+   static const uint32_t indexmark = 0xffffffff;
+
+   enum kind_type {is_false, is_true, signed_int, unsigned_int, fraction,
+      single, text, definition};
+
+   static const char* magic () { return "bdfrm\0\0\1"; }
+   static const char* indexmagic () { return "bdfrmidx"; }
+
+   static void put_fixed (string &out, unsigned long long value,
+         unsigned bytes) {
+      for (unsigned i=0; i<bytes; i++) out += char(value>>(8*i));
+   }
+
+   static void put_varint (string &out, unsigned long long value) {
+      while (value>=0x80) {
+         out += char(value|0x80);
+         value >>= 7;
+      }
+      out += char(value);
+   }
+
+   static unsigned long long zigzag (long long value) {
+      return (unsigned long long)value<<1 ^ (unsigned long long)(value>>63);
+   }
+};
+
+class bdframes_writer : public bdframes {
+public:
+
+   bdframes_writer () :lastnumber(0), written(0), startsframe(true) {}
+
+   // the writes append to the output, so that it is written as a whole
+   void header (string &out) {
+      out.append(magic(), 8);
+      written += 8;
+   }
+
+   // appends the event to the events of the record, the attributes sorted
+   // by their names and not repeated
+   void event (string &out, const char *type, const event_id &id,
+         const event_attribute *const *attributes, unsigned n) {
+      unsigned code = 0;
+      while (code<types-1 && strcmp(type_name(code), type)) code++;
+      if (id.name) {
+         out += char(code);
+         put_string(out, id.name, id.len, true);
+      }
+      else {
+         out += char(code|16);
+         put_varint(out, zigzag((long long)(id.number-lastnumber)));
+         lastnumber = id.number;
+      }
+      put_varint(out, n);
+      for (unsigned k=0; k<n; k++) put_attribute(out, *attributes[k]);
+   }
+
+   // writes the events as a record, which may end its frame
+   void record (string &out, const string &events, bool ends) {
+      if (startsframe) frames.push_back(written);
+      startsframe = ends;
+      put_fixed(out, (unsigned long long)events.size()<<1|ends, 4);
+      out += events;
+      written += 4+events.size();
+   }
+
+   void index (string &out) {
+      size_t start = out.size();
+      put_fixed(out, indexmark, 4);
+      put_fixed(out, frames.size(), 8);
+      for (size_t f=0; f<frames.size(); f++) put_fixed(out, frames[f], 8);
+      put_fixed(out, written, 8);
+      out.append(indexmagic(), 8);
+      written += out.size()-start;
+   }
+
+private:
+
+   void put_string (string &out, const char *s, size_t len, bool enters) {
+      unsigned entry = dictionary.find(s, len);
+      if (entry!=name_table::npos) {
+         put_varint(out, (unsigned long long)entry<<1);
+         return;
+      }
+      if (enters) dictionary.intern(s, len);
+      put_varint(out, (unsigned long long)len<<2 | (enters ? 1 : 3));
+      out.append(s, len);
+   }
+
+   void put_attribute (string &out, const event_attribute &a) {
+      size_t len = strlen(a.name);
+      unsigned name = names.find(a.name, len);
+      if (name==name_table::npos) {
+         name = names.intern(a.name, len);
+         put_varint(out, definition);
+         put_varint(out, len);
+         out.append(a.name, len);
+      }
+      unsigned long long head = (unsigned long long)name<<3;
+      switch (a.kind) {
+      case event_attribute::real: put_real(out, head, a.d); break;
+      case event_attribute::single:
+         put_varint(out, head|single);
+         put_float(out, a.d);
+         break;
+      case event_attribute::integer:
+         put_varint(out, head|signed_int);
+         put_varint(out, zigzag(a.i));
+         break;
+      case event_attribute::uinteger:
+         put_varint(out, head|unsigned_int);
+         put_varint(out, a.u);
+         break;
+      case event_attribute::flag: put_varint(out, head|(a.b ? is_true : is_false)); break;
+      case event_attribute::text:
+         put_varint(out, head|text);
+         put_string(out, a.s.data(), a.s.size(),
+            !strcmp(a.name, "source") || !strcmp(a.name, "target"));
+         break;
+      }
+   }
+
+   void put_real (string &out, unsigned long long head, double value) {
+      if (value>-1e15 && value<1e15 && value==(long long)value
+            && (value!=0 || !signbit(value))) {
+         put_varint(out, head|signed_int);
+         put_varint(out, zigzag((long long)value));
+         return;
+      }
+      if (value>0 && value<1) {
+         long q = lround(value*255);
+         if (q/255.0==value) {
+            put_varint(out, head|fraction);
+            out += char(q);
+            return;
+         }
+      }
+      put_varint(out, head|single);
+      put_float(out, value);
+   }
+
+   static void put_float (string &out, double value) {
+      float f = (float)value;
+      uint32_t bits;
+      memcpy(&bits, &f, sizeof(bits));
+      put_fixed(out, bits, 4);
+   }
+
+   name_table dictionary, names;
+   unsigned long long lastnumber;
+   unsigned long long written; // bytes written to the output
+   vector <unsigned long long> frames; // offset of each frame
+   bool startsframe; // the next record starts a frame
+};
+
+// Reads the frames in the order in which they were written, so that the
+// input may be a stream, and gives back their JSON events
+class bdframes_reader : public bdframes {
+public:
+
+   bdframes_reader (istream &in) :in(in), lastnumber(0), failure(false) {
+      char head[8];
+      if (!in.read(head, 8) || memcmp(head, magic(), 8)) failure = true;
+   }
+
+   // the input is not in the format, or it is truncated or corrupt
+   bool failed () const { return failure; }
+
+   // appends the line of the JSON events of the next frame, returns false
+   // at the end of the frames
+   bool next_frame (string &json) {
+      if (failure) return false;
+      size_t begin = json.size();
+      bool ends = false;
+      while (!ends) {
+         unsigned char head[4];
+         if (!in.read((char*)head, 4)) {
+            // the input ends between the frames when it was not closed
+            if (in.gcount()!=0 || json.size()!=begin) failure = true;
+            return false;
+         }
+         uint32_t h = head[0] | head[1]<<8 | head[2]<<16 | (uint32_t)head[3]<<24;
+         if (h==indexmark) {
+            if (json.size()!=begin) failure = true;
+            return false;
+         }
+         ends = h&1;
+         events.resize(h>>1);
+         if (!in.read(events.data(), events.size())) {
+            failure = true;
+            return false;
+         }
+         if (!decode(json)) {
+            failure = true;
+            return false;
+         }
+      }
+      if (json.size()==begin) json += "{}";
+      json += '\n';
+      return true;
+   }
+
+private:
+
+   bool decode (string &json) {
+      const unsigned char *p = (const unsigned char*)events.data();
+      const unsigned char *end = p+events.size();
+      unsigned long long v, n;
+      while (p<end) {
+         unsigned code = *p++;
+         if ((code&15)>=types) return false;
+         if (code&16) {
+            if (!get_varint(p, end, v)) return false;
+            lastnumber += (unsigned long long)unzigzag(v);
+            idname.clear();
+         }
+         else if (!get_string(p, end, idname)) return false;
+         if (!get_varint(p, end, n) || n>maxattributes) return false;
+         for (unsigned k=0; k<n; k++)
+            if (!get_attribute(p, end, attributes[k])) return false;
+         for (unsigned k=0; k<n; k++) sorted[k] = &attributes[k];
+         event_id id = (code&16) ? event_id(lastnumber)
+                                 : event_id(idname.data(), idname.size());
+         json_events::event(json, type_name(code&15), id, sorted, n);
+      }
+      return true;
+   }
+
+   bool get_string (const unsigned char *&p, const unsigned char *end,
+         string &s) {
+      unsigned long long v;
+      if (!get_varint(p, end, v)) return false;
+      if (!(v&1)) {
+         if ((v>>1)>=dictionary.size()) return false;
+         s.assign(dictionary.c_str(v>>1), dictionary.length(v>>1));
+         return true;
+      }
+      unsigned long long len = v>>2;
+      if ((unsigned long long)(end-p)<len) return false;
+      s.assign((const char*)p, len);
+      p += len;
+      if (!(v&2)) dictionary.intern(s);
+      return true;
+   }
+
+   bool get_attribute (const unsigned char *&p, const unsigned char *end,
+         event_attribute &a) {
+      unsigned long long v;
+      if (!get_varint(p, end, v)) return false;
+      if (v==definition) {
+         unsigned long long len;
+         if (!get_varint(p, end, len) || (unsigned long long)(end-p)<len)
+            return false;
+         names.intern((const char*)p, len);
+         p += len;
+         if (!get_varint(p, end, v)) return false;
+      }
+      if ((v>>3)>=names.size()) return false;
+      a.name = names.c_str(v>>3);
+      switch (v&7) {
+      case is_false: case is_true:
+         a.kind = event_attribute::flag;
+         a.b = (v&7)==is_true;
+         return true;
+      case signed_int:
+         a.kind = event_attribute::integer;
+         if (!get_varint(p, end, v)) return false;
+         a.i = unzigzag(v);
+         return true;
+      case unsigned_int:
+         a.kind = event_attribute::uinteger;
+         return get_varint(p, end, a.u);
+      case fraction:
+         if (p==end) return false;
+         a.kind = event_attribute::real;
+         a.d = *p++/255.0;
+         return true;
+      case single: {
+         if (end-p<4) return false;
+         uint32_t bits = p[0] | p[1]<<8 | p[2]<<16 | (uint32_t)p[3]<<24;
+         p += 4;
+         float f;
+         memcpy(&f, &bits, sizeof(f));
+         a.kind = event_attribute::single;
+         a.d = f;
+         return true;
+      }
+      case text:
+         a.kind = event_attribute::text;
+         return get_string(p, end, a.s);
+      }
+      return false;
+   }
+
+   static bool get_varint (const unsigned char *&p, const unsigned char *end,
+         unsigned long long &value) {
+      value = 0;
+      for (unsigned shift=0; p<end && shift<64; shift+=7) {
+         unsigned char byte = *p++;
+         value |= (unsigned long long)(byte&0x7f)<<shift;
+         if (!(byte&0x80)) return true;
+      }
+      return false;
+   }
+
+   static long long unzigzag (unsigned long long value) {
+      return (long long)(value>>1) ^ -(long long)(value&1);
+   }
+
+   static const unsigned maxattributes = 16;
+
+   istream &in;
+   vector <char> events;
+   name_table dictionary;
+   name_table names; // of the attributes
+   unsigned long long lastnumber;
+   string idname;
+   event_attribute attributes[maxattributes];
+   const event_attribute *sorted[maxattributes];
+   bool failure;
+};
+
+#endif
@@ -6,13 +6,17 @@
 #ifndef VIZ_CLIENT_HPP
 #define VIZ_CLIENT_HPP
 
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/lexical_cast.hpp>
-#include <json/json.h>
+
+#include <util/async_writer.hpp>
+#include <viz/bdframes.hpp>
+#include <viz/json_events.hpp>
 
 using namespace std;
 using boost::lexical_cast;
@@ -20,8 +24,12 @@ using boost::lexical_cast;
 
 class client_base {
 public:	
+	client_base() :nattributes(0) {}
 	
 	virtual void update()=0 ;
+	// sends the events of the frame produced so far, a large frame is sent
+	// in chunks of bounded size instead of being held whole
+	virtual void send_chunk()=0 ;
 	
 	template <class TT0> void add_node(TT0 id) {produce_event("an", id);}
 	template <class TT0> void change_node(TT0 id) {produce_event("cn", id);}
@@ -35,224 +43,106 @@ public:
 	template <class TT0> void change_label(TT0 id) {produce_event("cl", id);}
 	template <class TT0> void delete_label(TT0 id) {produce_event_no_attributes("dl", id);}
 	
-	template <class TT0, class T2> void add_node(TT0 id, T2 &extattr) 
-   {produce_event("an", id, extattr);}
-	template <class TT0, class T2> void change_node(TT0 id, T2 &extattr) 
-   {produce_event("cn", id, extattr);}
-	template <class TT0, class T2> void delete_node(TT0 id, T2 &extattr) 
-   {produce_event("dn", id, extattr);}
+	// the attributes of the next events, given as pairs of a name and a
+	// value; the names are string literals, the numbers are kept as they
+	// are until an event is written and the strings are copied into
+	// buffers that are reused, so that setting them does not allocate
+	template <class... TT>
+	void set_attributes(const TT&... pairs) {
+		static_assert(sizeof...(TT)%2==0, "attributes come in pairs");
+		static_assert(sizeof...(TT)<=2*maxattributes, "too many attributes");
+		nattributes = 0;
+		add_attributes(pairs...);
+	}
 	
-	template <class TT0, class T2> void add_edge(TT0 id, T2 &extattr) 
-   {produce_event("ae", id, extattr);}
-	template <class TT0, class T2> void change_edge(TT0 id, T2 &extattr) 
-   {produce_event("ce", id, extattr);}
-	template <class TT0, class T2> void delete_edge(TT0 id, T2 &extattr) 
-   {produce_event("de", id, extattr);}
+	// the queue depth and the write latency of the output since the last
+	// call, and the frames it dropped or coalesced, see async_writer
+	virtual void get_outputstats(char *stats) { stats[0]=0; }
+	virtual void get_outputtotals(char *totals) { totals[0]=0; }
+	// whether the next frame is not to be made as the output is behind, its
+	// changes are then sent with the next frame made
+	virtual bool drop_frame() { return false; }
 	
-	template <class TT0, class T2> void add_label(TT0 id, T2 &extattr) 
-   {produce_event("al", id, extattr);}
-	template <class TT0, class T2> void change_label(TT0 id, T2 &extattr) 
-   {produce_event("cl", id, extattr);}
-	template <class TT0, class T2> void delete_label(TT0 id, T2 &extattr) 
-   {produce_event("dl", id, extattr);}
+	virtual ~client_base() {}
 	
-	/* attributes implemented with std::map (it's slower)
-	template <class TT1>
-	void set_attributes(string a1, TT1 v1) {
-		attributes[a1]=lexical_cast<string>(v1);
-	}
-	template <class TT1, class TT2>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2) {
-		attributes[a1]=lexical_cast<string>(v1);
-		attributes[a2]=lexical_cast<string>(v2);
-	}
-	template <class TT1, class TT2, class TT3>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3) {
-		attributes[a1]=lexical_cast<string>(v1);
-		attributes[a2]=lexical_cast<string>(v2);
-		attributes[a3]=lexical_cast<string>(v3);
-	}
-	template <class TT1, class TT2, class TT3, class TT4>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-							  string a4, TT4 v4) {
-		attributes[a1]=lexical_cast<string>(v1);
-		attributes[a2]=lexical_cast<string>(v2);
-		attributes[a3]=lexical_cast<string>(v3);
-		attributes[a4]=lexical_cast<string>(v4);
-	}
-	template <class TT1, class TT2, class TT3, class TT4, class TT5>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-							  string a4, TT4 v4, string a5, TT5 v5) {
-		attributes[a1]=lexical_cast<string>(v1);
-		attributes[a2]=lexical_cast<string>(v2);
-		attributes[a3]=lexical_cast<string>(v3);
-		attributes[a4]=lexical_cast<string>(v4);
-		attributes[a5]=lexical_cast<string>(v5);
-	}
-	template <class TT1, class TT2, class TT3, class TT4, class TT5, class TT6>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-							  string a4, TT4 v4, string a5, TT5 v5, string a6, TT6 v6) {
-		attributes[a1]=lexical_cast<string>(v1);
-		attributes[a2]=lexical_cast<string>(v2);
-		attributes[a3]=lexical_cast<string>(v3);
-		attributes[a4]=lexical_cast<string>(v4);
-		attributes[a5]=lexical_cast<string>(v5);
-		attributes[a6]=lexical_cast<string>(v6);
-	}
-	template <class TT1, class TT2, class TT3, class TT4, class TT5, class TT6, 
-				 class TT7>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-							  string a4, TT4 v4, string a5, TT5 v5, string a6, TT6 v6,
-							  string a7, TT7 v7) {
-		attributes[a1]=lexical_cast<string>(v1);
-		attributes[a2]=lexical_cast<string>(v2);
-		attributes[a3]=lexical_cast<string>(v3);
-		attributes[a4]=lexical_cast<string>(v4);
-		attributes[a5]=lexical_cast<string>(v5);
-		attributes[a6]=lexical_cast<string>(v6);
-		attributes[a7]=lexical_cast<string>(v7);
-	}
-	template <class TT1, class TT2, class TT3, class TT4, class TT5, class TT6, 
-				 class TT7, class TT8>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-								string a4, TT4 v4, string a5, TT5 v5, string a6, TT6 v6,
-								string a7, TT7 v7, string a8, TT8 v8) {
-		attributes[a1]=lexical_cast<string>(v1);
-		attributes[a2]=lexical_cast<string>(v2);
-		attributes[a3]=lexical_cast<string>(v3);
-		attributes[a4]=lexical_cast<string>(v4);
-		attributes[a5]=lexical_cast<string>(v5);
-		attributes[a6]=lexical_cast<string>(v6);
-		attributes[a7]=lexical_cast<string>(v7);
-		attributes[a8]=lexical_cast<string>(v8);
-	}*/
+protected:
+	static const size_t maxtask = 1<<20;
+	string task;
 	
-	template <class TT1>
-	void set_attributes(string a1, TT1 v1) {
-		attributes.clear();
-		attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
-	}
-	template <class TT1, class TT2>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2) {
-		attributes.clear();
-		attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
-		attributes.push_back(pair<string, string>(a2,lexical_cast<string>(v2)));
-	}
-	template <class TT1, class TT2, class TT3>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3) {
-		attributes.clear();
-		attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
-		attributes.push_back(pair<string, string>(a2,lexical_cast<string>(v2)));
-		attributes.push_back(pair<string, string>(a3,lexical_cast<string>(v3)));
-	}
-	template <class TT1, class TT2, class TT3, class TT4>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-								string a4, TT4 v4) {
-		attributes.clear();
-		attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
-		attributes.push_back(pair<string, string>(a2,lexical_cast<string>(v2)));
-		attributes.push_back(pair<string, string>(a3,lexical_cast<string>(v3)));
-		attributes.push_back(pair<string, string>(a4,lexical_cast<string>(v4)));
-	}
-	template <class TT1, class TT2, class TT3, class TT4, class TT5>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-								string a4, TT4 v4, string a5, TT5 v5) {
-		attributes.clear();
-		attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
-		attributes.push_back(pair<string, string>(a2,lexical_cast<string>(v2)));
-		attributes.push_back(pair<string, string>(a3,lexical_cast<string>(v3)));
-		attributes.push_back(pair<string, string>(a4,lexical_cast<string>(v4)));
-		attributes.push_back(pair<string, string>(a5,lexical_cast<string>(v5)));
-	}
-	template <class TT1, class TT2, class TT3, class TT4, class TT5, class TT6>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-								string a4, TT4 v4, string a5, TT5 v5, string a6, TT6 v6) {
-		attributes.clear();
-		attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
-		attributes.push_back(pair<string, string>(a2,lexical_cast<string>(v2)));
-		attributes.push_back(pair<string, string>(a3,lexical_cast<string>(v3)));
-		attributes.push_back(pair<string, string>(a4,lexical_cast<string>(v4)));
-		attributes.push_back(pair<string, string>(a5,lexical_cast<string>(v5)));
-		attributes.push_back(pair<string, string>(a6,lexical_cast<string>(v6)));
-	}
-	template <class TT1, class TT2, class TT3, class TT4, class TT5, class TT6, 
-	class TT7>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-								string a4, TT4 v4, string a5, TT5 v5, string a6, TT6 v6,
-								string a7, TT7 v7) {
-		attributes.clear();
-		attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
-		attributes.push_back(pair<string, string>(a2,lexical_cast<string>(v2)));
-		attributes.push_back(pair<string, string>(a3,lexical_cast<string>(v3)));
-		attributes.push_back(pair<string, string>(a4,lexical_cast<string>(v4)));
-		attributes.push_back(pair<string, string>(a5,lexical_cast<string>(v5)));
-		attributes.push_back(pair<string, string>(a6,lexical_cast<string>(v6)));
-		attributes.push_back(pair<string, string>(a7,lexical_cast<string>(v7)));
-	}
-	template <class TT1, class TT2, class TT3, class TT4, class TT5, class TT6, 
-	class TT7, class TT8>
-	void set_attributes(string a1, TT1 v1, string a2, TT2 v2, string a3, TT3 v3,
-								string a4, TT4 v4, string a5, TT5 v5, string a6, TT6 v6,
-								string a7, TT7 v7, string a8, TT8 v8) {
-		attributes.clear();
-		attributes.push_back(pair<string, string>(a1,lexical_cast<string>(v1)));
-		attributes.push_back(pair<string, string>(a2,lexical_cast<string>(v2)));
-		attributes.push_back(pair<string, string>(a3,lexical_cast<string>(v3)));
-		attributes.push_back(pair<string, string>(a4,lexical_cast<string>(v4)));
-		attributes.push_back(pair<string, string>(a5,lexical_cast<string>(v5)));
-		attributes.push_back(pair<string, string>(a6,lexical_cast<string>(v6)));
-		attributes.push_back(pair<string, string>(a7,lexical_cast<string>(v7)));
-		attributes.push_back(pair<string, string>(a8,lexical_cast<string>(v8)));
+	// writes the event into the task, with its attributes sorted by their
+	// names and not repeated
+	virtual void write_event(const char *type, const event_id &id,
+			const event_attribute *const *attributes, unsigned n) {
+		json_events::event(task, type, id, attributes, n);
 	}
 	
-protected:
-	string task;
 private:
-	//map <string, string> attributes;
-	vector <pair <string, string> > attributes;
-	Json::FastWriter jsonwriter;
+	static const unsigned maxattributes = 8;
+	
+	event_attribute attributes[maxattributes];
+	unsigned nattributes;
+	unsigned order[maxattributes]; // of the attributes sorted by their names
+	const event_attribute *sorted[maxattributes];
 	
-	// note that T2 has to be a container of pairs
-	//TODO is this as optimal as passing pointers as arguments?
-	template <class TT0, class T2>
-	void produce_event(string type, TT0 id, T2 &extattr) {
-		Json::Value jsonroot;
-		jsonroot[type][lexical_cast<string>(id)]=Json::Value(Json::objectValue);
-		typedef typename T2::iterator ittype;
-		for (ittype it=extattr.begin(); it!=extattr.end(); it++)
-			jsonroot[type][lexical_cast<string>(id)][lexical_cast<string>((*it).first)]=(*it).second;
-		task+=jsonwriter.write(jsonroot);
-		*task.rbegin()='\r';
-		
+	void add_attributes() {}
+	template <class TT1, class... TT>
+	void add_attributes(const char *name, const TT1 &value, const TT&... rest) {
+		event_attribute &a = attributes[nattributes++];
+		a.name = name;
+		set_value(a, value);
+		add_attributes(rest...);
 	}
 	
+	typedef event_attribute attr;
+	static void set_value(attr &a, double v) { a.kind=attr::real; a.d=v; }
+	static void set_value(attr &a, float v) { a.kind=attr::single; a.d=v; }
+	static void set_value(attr &a, bool v) { a.kind=attr::flag; a.b=v; }
+	static void set_value(attr &a, int v) { a.kind=attr::integer; a.i=v; }
+	static void set_value(attr &a, long v) { a.kind=attr::integer; a.i=v; }
+	static void set_value(attr &a, long long v) { a.kind=attr::integer; a.i=v; }
+	static void set_value(attr &a, unsigned v) { a.kind=attr::uinteger; a.u=v; }
+	static void set_value(attr &a, unsigned long v) { a.kind=attr::uinteger; a.u=v; }
+	static void set_value(attr &a, unsigned long long v) { a.kind=attr::uinteger; a.u=v; }
+	static void set_value(attr &a, const char *v) { a.kind=attr::text; a.s.assign(v); }
+	static void set_value(attr &a, const string &v) { a.kind=attr::text; a.s.assign(v); }
+	
+	// the attributes are written as Json::FastWriter writes them, sorted by
+	// their names with the last value of a name
 	template <class TT0> 
-	void produce_event(string type, TT0 id) {
-		Json::Value jsonroot;		
-		//decltype(attributes)::iterator it; //
-		jsonroot[type][lexical_cast<string>(id)]=Json::Value(Json::objectValue);
-		for (vector <pair <string, string> >:: iterator it=attributes.begin();
-			it!=attributes.end(); it++)
-			jsonroot[type][lexical_cast<string>(id)][(*it).first]=(*it).second;
-		task+=jsonwriter.write(jsonroot);
-		*task.rbegin()='\r';
+	void produce_event(const char *type, const TT0 &id) {
+		for (unsigned k=0; k<nattributes; k++) {
+			unsigned j = k;
+			for (; j>0 && strcmp(attributes[order[j-1]].name, attributes[k].name)>0; j--)
+				order[j] = order[j-1];
+			order[j] = k;
+		}
+		unsigned n = 0;
+		for (unsigned j=0; j<nattributes; j++)
+			if (j+1==nattributes
+					|| strcmp(attributes[order[j+1]].name, attributes[order[j]].name))
+				sorted[n++] = &attributes[order[j]];
+		write_event(type, event_id(id), sorted, n);
+		if (task.size()>=maxtask) send_chunk();
 	}
 	
 	template <class TT0> 
-	void produce_event_no_attributes(string type, TT0 id) {
-		Json::Value jsonroot;
-		jsonroot[type][id]=Json::Value(Json::objectValue);
-		task+=jsonwriter.write(jsonroot);
-		*task.rbegin()='\r';
+	void produce_event_no_attributes(const char *type, const TT0 &id) {
+		write_event(type, event_id(id), sorted, 0);
+		if (task.size()>=maxtask) send_chunk();
 	}
 };
 
+// the output is written by a writer thread when the queue is not 0, the
+// frames of the clients are handed over to it whole or in chunks
 class client_file : public client_base {
 public:
-	client_file() {
+	client_file()
+	:chunksent(false), writer(sink(), 0, async_writer::block) {
 		output.open(((string)"defaultout"+".json").c_str());
 	}
-	client_file(string name) {
+	client_file(string name, unsigned queue=0,
+			async_writer::policy_type policy=async_writer::block)
+	:chunksent(false), writer(sink(), queue, policy) {
 		output.open((name+".json").c_str());
       cout<<"Opening file "<<(name+".json").c_str()<<endl;
       if (output.fail()) {
@@ -262,14 +152,97 @@ public:
 	}
 	
 	void update(){
-		output<<task;
-		if (task.size()==0) output<<"{}";
-		output<<"\n";
-		task="";
+		if (task.size()==0 && !chunksent) task="{}";
+		task+='\n';
+		writer.push(task, true);
+		chunksent=false;
+	}
+
+	// the frame stays on a single line
+	void send_chunk(){
+		if (task.size()) writer.push(task, false);
+		chunksent=true;
 	}
 	
+	void get_outputstats(char *stats) { writer.get_stats(stats); }
+	void get_outputtotals(char *totals) { writer.get_totals(totals); }
+	bool drop_frame() { return writer.drop_frame(); }
+	
 private:
 	ofstream output;
+	bool chunksent; // a part of the frame has been written
+	async_writer writer; // the last member, it stops before the output closes
+	
+	// each frame is flushed, so that the file can be followed
+	async_writer::sink_type sink() {
+		return [this](const string &data, bool ends) {
+			output.write(data.data(), data.size());
+			if (ends) output.flush();
+		};
+	}
+};
+
+// writes the events in the binary format of bdframes.hpp instead of JSON,
+// each frame is flushed as it is by client_file
+class client_binary : public client_base {
+public:
+	client_binary(string name, unsigned queue=0,
+			async_writer::policy_type policy=async_writer::block)
+	:writer(sink(), queue, policy) {
+		output.open(name.c_str(), ios::binary);
+		cout<<"Opening file "<<name<<endl;
+		if (output.fail()) {
+			cout<<"Uuuups, could not open the file! Terminated."<<endl;
+			exit(1);
+		}
+		frames.header(record);
+		output.write(record.data(), record.size());
+		record.clear();
+	}
+	
+	// the index of the frames ends the file
+	~client_binary() {
+		writer.close();
+		frames.index(record);
+		output.write(record.data(), record.size());
+	}
+	
+	void update(){
+		frames.record(record, task, true);
+		task.clear();
+		writer.push(record, true);
+	}
+	
+	void send_chunk(){
+		if (task.size()) {
+			frames.record(record, task, false);
+			task.clear();
+			writer.push(record, false);
+		}
+	}
+	
+	void get_outputstats(char *stats) { writer.get_stats(stats); }
+	void get_outputtotals(char *totals) { writer.get_totals(totals); }
+	bool drop_frame() { return writer.drop_frame(); }
+	
+protected:
+	void write_event(const char *type, const event_id &id,
+			const event_attribute *const *attributes, unsigned n) {
+		frames.event(task, type, id, attributes, n);
+	}
+	
+private:
+	ofstream output;
+	bdframes_writer frames;
+	string record; // the record of the events handed over to the writer
+	async_writer writer;
+	
+	async_writer::sink_type sink() {
+		return [this](const string &data, bool ends) {
+			output.write(data.data(), data.size());
+			if (ends) output.flush();
+		};
+	}
 };
 
-#endif
\ No newline at end of file
+#endif
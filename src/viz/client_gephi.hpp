@@ -12,36 +12,56 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/network/protocol/http/client.hpp>
-#include <json/json.h>
 
+#include <util/async_writer.hpp>
 #include <viz/client.hpp>
 
 using namespace std;
 
 
+// the frames are posted to the url of the workspace, see
+// client_gephi_stream::endpoint, by a writer thread when the queue is not
+// 0, see client_file
 class client_gephi : public client_base {
 public:
 	client_gephi()
-	:request("http://localhost:8080/workspace0?operation=updateGraph") {
+	:request("http://localhost:8080/workspace0?operation=updateGraph"),
+	writer(sink(), 0, async_writer::block) {
 		//output.open(((string)"defaultout"+".json").c_str());
 	}
-	client_gephi(string host, string name="defaultout")
-   :request(host+":8080/workspace0?operation=updateGraph") {
-      cout<<"Connecting to: "<<host+":8080/workspace0?operation=updateGraph"<<endl;
+	client_gephi(string url, string name="defaultout", unsigned queue=0,
+			async_writer::policy_type policy=async_writer::block)
+   :request(url),
+   writer(sink(), queue, policy) {
+      cout<<"Connecting to: "<<url<<endl;
 		//output.open((name+".json").c_str());
 	}
 	
 	void update(){
 		//output<<task<<endl;
-		response = client.post(request, task);
-		task="";
+		writer.push(task, true);
 		//cout << body(response) << endl;
 	}
+
+	void send_chunk(){
+		if (task.size()) writer.push(task, false);
+	}
+	
+	void get_outputstats(char *stats) { writer.get_stats(stats); }
+	void get_outputtotals(char *totals) { writer.get_totals(totals); }
+	bool drop_frame() { return writer.drop_frame(); }
 	
 private:
 	boost::network::http::client client;
 	boost::network::http::client::request request;
 	boost::network::http::client::response response;
+	async_writer writer; // the last member, it stops before the client
+	
+	async_writer::sink_type sink() {
+		return [this](const string &data, bool) {
+			response = client.post(request, data);
+		};
+	}
 };
 
 #endif
@@ -0,0 +1,86 @@
+/*
+ * Streams differential changes between consecutive states of a network
+ * in JSON format to the Gephi Streaming API over one connection kept open
+ */
+
+#ifndef VIZ_CLIENT_GEPHI_STREAM_HPP
+#define VIZ_CLIENT_GEPHI_STREAM_HPP
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <util/async_writer.hpp>
+#include <util/http_stream.hpp>
+#include <viz/client.hpp>
+
+using namespace std;
+
+
+// the frames are sent as chunks of requests of a batch of frames, which
+// are sent again until their request is acknowledged, see http_stream;
+// they are sent by a writer thread when the queue is not 0, see client_file;
+// the requests are given up after a few tries once the flag going is
+// cleared or the client is destroyed
+class client_gephi_stream : public client_base {
+public:
+	client_gephi_stream(string server, unsigned batch=30, unsigned retries=0,
+			unsigned queue=0, async_writer::policy_type policy=async_writer::block,
+			const volatile sig_atomic_t *going=0)
+	:stream(endpoint(server), batch, retries, timeout, going),
+	writer(sink(), queue, policy) {
+		cout<<"Streaming to: "<<endpoint(server)<<endl;
+		if (!stream.is_valid()) {
+			cout<<"Uuuups, the server is not an http:// address! Terminated."<<endl;
+			exit(1);
+		}
+	}
+
+	// the frames waiting are sent and the last request is acknowledged, or
+	// given up after a few tries
+	~client_gephi_stream() {
+		stream.stop();
+		writer.close();
+		stream.flush();
+		cout<<"Connections to the server: "<<stream.get_connections()
+			<<", frames sent again: "<<stream.get_resent()
+			<<", frames lost: "<<stream.get_lost()<<endl;
+	}
+
+	void update(){
+		writer.push(task, true);
+	}
+
+	void send_chunk(){
+		if (task.size()) writer.push(task, false);
+	}
+
+	void get_outputstats(char *stats) { writer.get_stats(stats); }
+	void get_outputtotals(char *totals) { writer.get_totals(totals); }
+	bool drop_frame() { return writer.drop_frame(); }
+
+	// the url of the workspace, the host alone stands for the default
+	// workspace of Gephi on its port 8080 unless an other port is given
+	static string endpoint(string server) {
+		size_t start = server.find("://");
+		start = start==string::npos ? 0 : start+3;
+		if (server.find('/', start)!=string::npos) return server;
+		if (server.find(':', start)==string::npos) server += ":8080";
+		return server+"/workspace0?operation=updateGraph";
+	}
+
+private:
+	static constexpr double timeout = 10; // seconds without progress
+
+	http_stream stream;
+	async_writer writer; // the last member, it stops before the stream
+
+	async_writer::sink_type sink() {
+		return [this](const string &data, bool ends) {
+			stream.send(data, ends);
+		};
+	}
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Ids of the edges sent to the output client with their last weight sent,
+ * keyed by the positions of their two nodes in the collector
+ *
+ * Only the few edges of the visualized nodes have an id, so they are kept
+ * in an open-addressing hash table instead of a matrix over all the stored
+ * positions. Each position also lists its neighbours, so that the edges of
+ * a removed node are cleared in time proportional to its degree. The lists
+ * are not updated when a neighbour is cleared, their stale entries are
+ * dropped when the list fills its capacity.
+ */
+
+#ifndef VIZ_EDGE_ID_MAP_HPP
+#define VIZ_EDGE_ID_MAP_HPP
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+class edge_id_map {
+public:
+
+   struct entry {
+      unsigned long id; // 0 for an empty slot
+      double weight;
+   };
+
+   edge_id_map (const unsigned size)
+      :slots(16), used(0), neighbours(size) {}
+
+   // the edge between i and j, 0 if it has none; the entry moves when
+   // another edge is set
+   entry* find (unsigned i, unsigned j) {
+      size_t s = locate(key(i,j));
+      return slots[s].id ? &slots[s] : 0;
+   }
+
+   // id of the edge between i and j, 0 if it has none
+   unsigned long get (unsigned i, unsigned j) const {
+      return slots[locate(key(i,j))].id;
+   }
+
+   // the id is not 0
+   void set (unsigned i, unsigned j, unsigned long id, double weight=0) {
+      if (2*(used+1)>slots.size()) grow();
+      unsigned long long k = key(i,j);
+      size_t s = locate(k);
+      bool added = !slots[s].id;
+      slots[s].key = k;
+      slots[s].id = id;
+      slots[s].weight = weight;
+      if (!added) return;
+      used++;
+      add_neighbour(i, j);
+      add_neighbour(j, i);
+   }
+
+   // removes the ids of all the edges of the node
+   void clear_node (unsigned i) {
+      vector <unsigned> &n = neighbours[i];
+      for (unsigned k=0; k<n.size(); k++) erase(key(i,n[k]));
+      vector <unsigned>().swap(n);
+   }
+
+   size_t size () const { return used; }
+
+private:
+
+   struct slot : entry {
+      unsigned long long key;
+   };
+
+   static unsigned long long key (unsigned i, unsigned j) {
+      if (i>j) swap(i,j);
+      return (unsigned long long)i<<32 | j;
+   }
+
+   size_t home (unsigned long long k) const {
+      return (k*0x9E3779B97F4A7C15ULL>>32)&(slots.size()-1);
+   }
+
+   // slot of the key, or the empty slot where it would be added
+   size_t locate (unsigned long long k) const {
+      size_t s = home(k);
+      while (slots[s].id && slots[s].key!=k) s = (s+1)&(slots.size()-1);
+      return s;
+   }
+
+   // linear probing with backward shift, so that no tombstones are left
+   void erase (unsigned long long k) {
+      size_t mask = slots.size()-1, s = locate(k);
+      if (!slots[s].id) return;
+      for (size_t next=(s+1)&mask; slots[next].id; next=(next+1)&mask) {
+         size_t h = home(slots[next].key);
+         // the entry at next can move to s if its home is not within (s,next]
+         if (((next-h)&mask)>=((next-s)&mask)) {
+            slots[s] = slots[next];
+            s = next;
+         }
+      }
+      slots[s].id = 0;
+      used--;
+   }
+
+   void grow () {
+      vector <slot> old(2*slots.size());
+      old.swap(slots);
+      for (size_t o=0; o<old.size(); o++) if (old[o].id) {
+         size_t s = home(old[o].key);
+         while (slots[s].id) s = (s+1)&(slots.size()-1);
+         slots[s] = old[o];
+      }
+   }
+
+   void add_neighbour (unsigned i, unsigned j) {
+      vector <unsigned> &n = neighbours[i];
+      if (n.size()==n.capacity() && n.size()>=8) {
+         unsigned kept = 0;
+         for (unsigned k=0; k<n.size(); k++)
+            if (get(i,n[k])) n[kept++] = n[k];
+         n.resize(kept);
+         sort(n.begin(), n.end());
+         n.erase(unique(n.begin(), n.end()), n.end());
+         // keeps the pruning amortised when most neighbours are alive
+         if (2*n.size()>n.capacity()) n.reserve(2*n.capacity());
+      }
+      n.push_back(j);
+   }
+
+   vector <slot> slots;
+   size_t used;
+   vector <vector <unsigned> > neighbours; // may hold stale entries
+};
+
+#endif
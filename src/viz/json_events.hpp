@@ -0,0 +1,259 @@
+/*
+ * Writes the events of the Gephi Streaming API straight into a string,
+ * byte for byte as Json::FastWriter writes them
+ *
+ * An event is {"type":{"id":{"name":"value",...}}} followed by '\r'. The
+ * attributes of an object written by JsonCpp come sorted by their names,
+ * and their values are the strings given by lexical_cast. The strings are
+ * escaped as JsonCpp 1.9 does, which writes the characters outside of
+ * ASCII as \u escapes and replaces the invalid UTF-8 sequences.
+ */
+
+#ifndef VIZ_JSON_EVENTS_HPP
+#define VIZ_JSON_EVENTS_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// the digits of the floating point numbers are written by to_chars when
+// the standard library has it, which is several times faster than printf
+#if __cplusplus>=201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+using namespace std;
+
+// the id of an event, a name or a number
+struct event_id {
+   const char *name; // 0 for a number
+   size_t len;
+   unsigned long long number;
+
+   event_id (const char *name) :name(name), len(strlen(name)), number(0) {}
+   event_id (const string &name) :name(name.data()), len(name.size()),
+      number(0) {}
+   event_id (const char *name, size_t len) :name(name), len(len), number(0) {}
+   event_id (unsigned long long number) :name(0), len(0), number(number) {}
+   event_id (unsigned long number) :name(0), len(0), number(number) {}
+   event_id (unsigned number) :name(0), len(0), number(number) {}
+   event_id (int number) :name(0), len(0), number(number) {}
+};
+
+// an attribute of an event, whose value keeps its type until the event
+// is written
+struct event_attribute {
+   enum kind_type {real, single, integer, uinteger, flag, text};
+   const char *name;
+   kind_type kind;
+   double d; // real and single
+   long long i;
+   unsigned long long u;
+   bool b;
+   string s; // text
+};
+
+class json_events {
+public:
+
+   // the event with its attributes, which are sorted by their names and
+   // not repeated
+   static void event (string &out, const char *type, const event_id &id,
+         const event_attribute *const *attributes, unsigned n) {
+      begin(out, type, id);
+      for (unsigned k=0; k<n; k++) {
+         const event_attribute &a = *attributes[k];
+         switch (a.kind) {
+         case event_attribute::real: attribute(out, k==0, a.name, a.d); break;
+         case event_attribute::single:
+            attribute(out, k==0, a.name, (float)a.d); break;
+         case event_attribute::integer: attribute(out, k==0, a.name, a.i); break;
+         case event_attribute::uinteger: attribute(out, k==0, a.name, a.u); break;
+         case event_attribute::flag: attribute(out, k==0, a.name, a.b); break;
+         case event_attribute::text: attribute(out, k==0, a.name, a.s); break;
+         }
+      }
+      end(out);
+   }
+
+   // {"type":{"id":{
+   template <class TT0>
+   static void begin (string &out, const char *type, const TT0 &id) {
+      out += "{\"";
+      out += type;
+      out += "\":{";
+      append_quoted(out, id);
+      out += ":{";
+   }
+
+   // "name":"value" after the attributes before it, which are sorted by
+   // their names and not repeated
+   template <class TT1>
+   static void attribute (string &out, bool first, const char *name,
+         const TT1 &value) {
+      if (!first) out += ',';
+      append_quoted(out, name, strlen(name));
+      out += ':';
+      append_quoted(out, value);
+   }
+
+   static void end (string &out) { out += "}}}\r"; }
+
+   static void append_quoted (string &out, const event_id &id) {
+      if (id.name) append_quoted(out, id.name, id.len);
+      else append_quoted(out, id.number);
+   }
+   static void append_quoted (string &out, const string &s) {
+      append_quoted(out, s.data(), s.size());
+   }
+   static void append_quoted (string &out, const char *s) {
+      append_quoted(out, s, strlen(s));
+   }
+   template <class TT0>
+   static void append_quoted (string &out, const TT0 &number) {
+      out += '"';
+      append_number(out, number);
+      out += '"';
+   }
+
+   static void append_quoted (string &out, const char *s, size_t len) {
+      out += '"';
+      size_t plain = 0;
+      while (plain<len && !escaped((unsigned char)s[plain])) plain++;
+      out.append(s, plain);
+      if (plain<len) append_escaped(out, s+plain, s+len);
+      out += '"';
+   }
+
+   // the digits of an integer, as lexical_cast gives them
+   template <class TT0>
+   static void append_number (string &out, TT0 number) {
+      char digits[24];
+      char *p = digits+sizeof(digits);
+      bool negative = number<0;
+      unsigned long long n = negative ? 0-(unsigned long long)number
+                                      : (unsigned long long)number;
+      do {
+         *--p = '0'+n%10;
+         n /= 10;
+      } while (n);
+      if (negative) *--p = '-';
+      out.append(p, digits+sizeof(digits)-p);
+   }
+
+   // the 17 significant digits lexical_cast gives, the integral values
+   // take the path of the integers
+   static void append_number (string &out, double number) {
+      if (number>-1e15 && number<1e15 && number==(long long)number
+            && (number!=0 || !signbit(number))) {
+         append_number(out, (long long)number);
+         return;
+      }
+      // the colours repeat in every event, their digits are remembered
+      static thread_local formatted cache[64];
+      uint64_t bits;
+      memcpy(&bits, &number, sizeof(bits));
+      formatted &f = cache[(bits*0x9E3779B97F4A7C15ULL)>>58];
+      if (f.len==0 || f.bits!=bits) {
+         f.bits = bits;
+#ifdef __cpp_lib_to_chars
+         f.len = to_chars(f.digits, f.digits+sizeof(f.digits), number,
+            chars_format::general, 17).ptr-f.digits;
+#else
+         f.len = snprintf(f.digits, sizeof(f.digits), "%.17g", number);
+#endif
+      }
+      out.append(f.digits, f.len);
+   }
+   static void append_number (string &out, float number) {
+      char digits[32];
+#ifdef __cpp_lib_to_chars
+      out.append(digits, to_chars(digits, digits+sizeof(digits), number,
+         chars_format::general, 9).ptr-digits);
+#else
+      out.append(digits, snprintf(digits, sizeof(digits), "%.9g", number));
+#endif
+   }
+   static void append_number (string &out, bool value) {
+      out += value ? '1' : '0';
+   }
+
+private:
+
+   struct formatted {
+      uint64_t bits;
+      unsigned len; // 0 if empty
+      char digits[28];
+   };
+
+   static bool escaped (unsigned char c) {
+      return c<0x20 || c=='"' || c=='\\' || c>=0x80;
+   }
+
+   static void append_escaped (string &out, const char *s, const char *end) {
+      for (; s!=end; s++) {
+         switch (*s) {
+         case '"': out += "\\\""; break;
+         case '\\': out += "\\\\"; break;
+         case '\b': out += "\\b"; break;
+         case '\f': out += "\\f"; break;
+         case '\n': out += "\\n"; break;
+         case '\r': out += "\\r"; break;
+         case '\t': out += "\\t"; break;
+         default: {
+            unsigned codepoint = next_codepoint(s, end);
+            if (codepoint<0x20 || (codepoint>=0x80 && codepoint<0x10000))
+               append_hex(out, codepoint);
+            else if (codepoint<0x80) out += (char)codepoint;
+            else {
+               codepoint -= 0x10000;
+               append_hex(out, 0xd800+((codepoint>>10)&0x3ff));
+               append_hex(out, 0xdc00+(codepoint&0x3ff));
+            }
+         }
+         }
+      }
+   }
+
+   // the code point starting at s, which is left at its last byte; the
+   // sequences are decoded as loosely as JsonCpp does
+   static unsigned next_codepoint (const char *&s, const char *end) {
+      const unsigned replacement = 0xfffd;
+      unsigned first = (unsigned char)*s;
+      if (first<0x80) return first;
+      if (first<0xe0) {
+         if (end-s<2) return replacement;
+         unsigned c = (first&0x1f)<<6 | (s[1]&0x3f);
+         s += 1;
+         return c<0x80 ? replacement : c;
+      }
+      if (first<0xf0) {
+         if (end-s<3) return replacement;
+         unsigned c = (first&0x0f)<<12 | (s[1]&0x3f)<<6 | (s[2]&0x3f);
+         s += 2;
+         if (c>=0xd800 && c<=0xdfff) return replacement;
+         return c<0x800 ? replacement : c;
+      }
+      if (first<0xf8) {
+         if (end-s<4) return replacement;
+         unsigned c = (first&0x07)<<18 | (s[1]&0x3f)<<12 | (s[2]&0x3f)<<6
+                      | (s[3]&0x3f);
+         s += 3;
+         return c<0x10000 ? replacement : c;
+      }
+      return replacement;
+   }
+
+   static void append_hex (string &out, unsigned codepoint) {
+      static const char hex[] = "0123456789abcdef";
+      char u[6] = {'\\', 'u', hex[codepoint>>12&0xf], hex[codepoint>>8&0xf],
+                   hex[codepoint>>4&0xf], hex[codepoint&0xf]};
+      out.append(u, 6);
+   }
+};
+
+#endif
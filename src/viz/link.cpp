@@ -5,18 +5,17 @@
 #ifndef VIZ_LINK_HPP
 #define VIZ_LINK_HPP
 
-#include <string>
 using namespace std;
 
 struct link_base {
 	unsigned eid; //id of the link
-  string name1, name2; //ids of the nodes
+  unsigned id1, id2; //ids of the node names
   double weight;
   double orgweigth;
 
-  link_base(string name1="", string name2="", double weight=-1) {
-  	this->name1=name1;
-  	this->name2=name2;
+  link_base(unsigned id1=-1, unsigned id2=-1, double weight=-1) {
+  	this->id1=id1;
+  	this->id2=id2;
   	this->weight=weight;
     this->orgweigth=weight;
   }
@@ -27,13 +26,18 @@ struct link_base {
   // bool operator==(const string &other) const {return nm==other;}
 };
 
-struct link_timed:link_base {
+// packed link kept in the time-window, the weight is the original one
+struct link_timed {
   long ts;
+  unsigned id1, id2; //ids of the node names
+  float weight;
 
-  link_timed(string name1="", string name2="", double weight=-1, long ts=-1)
-  	:link_base(name1, name2, weight) {
-  		this->ts=ts;
-  	}
+  link_timed(unsigned id1=-1, unsigned id2=-1, double weight=-1, long ts=-1) {
+  	this->id1=id1;
+  	this->id2=id2;
+  	this->weight=weight;
+  	this->ts=ts;
+  }
 };
 
 
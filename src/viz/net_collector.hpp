@@ -6,14 +6,13 @@
 #define VIZ_NET_COLLECTOR_HPP
 
 #include <cassert>
-#include <deque>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
-#include <set>
 #include <vector>
-#include <list>
 
 #include <pms/clock_collector.hpp>
+#include <util/indexed_heap.hpp>
 #include <viz/node.hpp>
 #include <viz/net_collector_base.hpp>
 
@@ -22,21 +21,22 @@ using namespace std;
 class net_collector : public net_collector_base {
 public:
 
-	net_collector (const unsigned maxstored, clock_collectors &mycc,
-			unsigned verbose=1)
-		:net_collector_base(maxstored) {
-			minstr=1e100;
+	net_collector (const unsigned maxstored, const name_table &nodenames,
+			clock_collectors &mycc, unsigned verbose=1, bool lazyforget=true)
+		:net_collector_base(maxstored, nodenames), stamp(maxstored,0),
+		weakest(maxstored, weaker(this)) {
+			laststamp=0;
 			nstored=0;
      		this->verbose=verbose;
 			myclockcollector=&mycc;
+			net.set_lazy_scaling(lazyforget);
 	}
 
-	void add_linkpack (vector <string> &linkpack, double weight=1,
+	void add_linkpack (vector <unsigned> &linkpack, double weight=1,
 			long ts=-1, int verbose=0) {
-		typedef typename vector <string>::const_iterator ittype;
+		typedef typename vector <unsigned>::const_iterator ittype;
 
 		double m=linkpack.size();
-		list<set<node_base>::iterator> toupdate;
 		double edgeincrement = weight; //edge score
 		double nodeincrement; //node score
 
@@ -51,147 +51,76 @@ public:
 
 		//------------------------------------------------------------------
 		// check if found nodes has already been stored, if not then add
-		{
-			unsigned iupd=0;
-			for (ittype fp = linkpack.begin(); fp != linkpack.end(); ++fp) {
-				// if (verbose==9) cout<<(*fp);
-
-				// stored?
-				node_base node;
-				node.nm=(*fp);
-				toupdate.push_back(stored.find(node));
-				myclockcollector->collect("TTTTfindinstored");
-
-				// debug
-				if (verbose>3) {
-					cout<<"New node: "<<node.nm<<" weight="<<weight<<" str="<<nodeincrement<<endl;
-					print_weakest();
-					print_stored();
-				}
+		toupdate.clear();
+		for (ittype fp = linkpack.begin(); fp != linkpack.end(); ++fp) {
+			unsigned id=(*fp);
+
+			// stored?
+			if (id>=stored.size()) stored.resize(id+1, name_table::npos);
+			unsigned pos=stored[id];
+			myclockcollector->collect("TTTTfindinstored");
+
+			// debug
+			if (verbose>3) {
+				cout<<"New node: "<<nodenames.c_str(id)<<" weight="<<weight<<" str="<<nodeincrement<<endl;
+				print_weakest();
+				print_stored();
+			}
 
-				// if not among the stored nodes
-				if (toupdate.back()==stored.end()) {
-
-					// let's add the new node
-					if (stored.size()<net.size()) {
-						node.pos=stored.size();
-						names[node.pos]=node.nm;
-						net[node.pos][node.pos]=nodeincrement;
-					}
-
-					// or exchange the weakest node with the new one
-					else {
-
-						// assign the position
-						assert(weakest.size()>0);
-						node.pos=weakest.front();
-
-						// erase from weakest, update stored names, and remove from stored names
-						weakest.pop_front();
-						{node_base weaknode; weaknode.nm=names[node.pos];
-						set<node_base>::iterator foundit=stored.find(weaknode);
-						assert(foundit!=stored.end());
-
-						auto it=toupdate.begin();
-						while ( it!=toupdate.end() ) {
-							if (*it==foundit) {
-								// cout<<"A node destined for update removed: "<<foundit->nm;
-								// cout<<" while adding node: "<<node.nm<<endl;
-								it=toupdate.erase(it);
-							}
-							else it++;
-						}
-
-
-						stored.erase(foundit);}
-						names[node.pos]=node.nm;
-
-						// update matrix of weights
-						for (unsigned j=0; j<net.size(); j++) {
-							net[j][node.pos]=0;
-							net[node.pos][j]=0;
-						}
-						net[node.pos][node.pos]=nodeincrement;
-
-						// in case of weakest empty find new weakest elements
-						refill_weakest();
-					}
-
-					// but if it's weak then it won't stay long...
-					if (nodeincrement<=minstr) {
-						if (nodeincrement<minstr) {
-							minstr=nodeincrement;
-							weakest.clear();
-							weakest.push_back(node.pos);
-						}
-						else {
-							weakest.push_back(node.pos);
-						}
-					}
-
-					// and let's insert the new node
-					pair<set<node_base>::iterator,bool> insres;
-					insres=stored.insert(node);
-					assert(insres.second);
-					toupdate.back()=insres.first;
+			// if not among the stored nodes
+			if (pos==name_table::npos) {
 
+				// let's add the new node
+				if (nstored<net.size()) {
+					pos=nstored++;
+					net.set(pos,pos,nodeincrement);
+					stamp[pos]=++laststamp;
+					weakest.push(pos);
 				}
 
-				// if among the stored nodes then update the node strength and the weakest set
+				// or exchange the weakest node with the new one
 				else {
 
-					// increment the score of the arriving node
-					node.pos=(*toupdate.back()).pos;
-					double prevstr=net[node.pos][node.pos];
-					net[node.pos][node.pos]+=nodeincrement;
-
-					// debug, shouldn't happen
-					if (prevstr<minstr) {
-						cout<<"Error: a node with strength lower than minstr "<<prevstr<<" < "<<minstr<<endl;
-						print_weakest();
-						print_stored();
-					}
-
-					// if it was in the weakest set then leave the set now
-					if (prevstr==minstr) {
-						{deque<unsigned>::iterator foundit=
-							find( weakest.begin(), weakest.end(), node.pos);
-						if (foundit!=weakest.end()) weakest.erase(foundit);}
-
-						// in case of weakest empty find new weakest elements
-						refill_weakest();
-					}
-
-					// debug, shouldn't happen
-					else {
-						deque<unsigned>::iterator foundit=
-							find( weakest.begin(), weakest.end(), node.pos);
-						if (foundit!=weakest.end()) {
-							cout<<"Error: found among weakest a node with strength "<<prevstr<<" > "<<minstr<<endl;
-							print_weakest();
-							print_stored();
-						}
-					}
-
-				}
+					// assign the position
+					assert(!weakest.empty());
+					pos=weakest.top();
 
+					// remove the weakest node from stored nodes and from the nodes
+					// destined for update if it has arrived in the same linkpack
+					stored[ids[pos]]=name_table::npos;
+					toupdate.erase( remove(toupdate.begin(), toupdate.end(), pos),
+						toupdate.end() );
 
-				// debug
-				if (verbose>3) {
-					cout<<"After buffering: "<<names[node.pos]<<" pos="<<node.pos
-						 <<" str="<<net[node.pos][node.pos]<<endl;
-					print_weakest();
-					print_stored();
+					// update matrix of weights
+					net.clear_node(pos);
+					net.set(pos,pos,nodeincrement);
 
-					deque<unsigned>::iterator foundit=
-						find( weakest.begin(), weakest.end(), node.pos);
-					if (net[node.pos][node.pos]>minstr && foundit!=weakest.end()) {
-						cout<<"This is a naughty node! (It's among the weakest but it's strength is high.)"<<endl;
-					}
-
-					cout<<endl;
+					// the new node takes the place of the weakest in the heap
+					stamp[pos]=++laststamp;
+					weakest.update(pos);
 				}
 
+				// and let's insert the new node
+				ids[pos]=id;
+				stored[id]=pos;
+			}
+
+			// if among the stored nodes then update the node strength and its
+			// place in the heap of the weakest nodes
+			else {
+				net.add(pos,pos,nodeincrement);
+				stamp[pos]=++laststamp;
+				weakest.update(pos);
+			}
+			toupdate.push_back(pos);
+
+			// debug
+			if (verbose>3) {
+				cout<<"After buffering: "<<nodenames.c_str(ids[pos])<<" pos="<<pos
+					 <<" str="<<net.get(pos,pos)<<endl;
+				print_weakest();
+				print_stored();
+				cout<<endl;
 			}
 		}
 
@@ -200,36 +129,9 @@ public:
 		// now it's time to strengthen connection weights of the arriving nodes
 		if (toupdate.size()>1)
 		{
-			for (auto it1 = toupdate.begin(); it1 != toupdate.end(); it1++) {
-				for (auto it2 = toupdate.begin(); it2 != toupdate.end(); it2++) {
-					unsigned pos1=(**it1).pos;
-					unsigned pos2=(**it2).pos;
-
-					// debug
-					//string nm1=(**it1).nm;
-					//string nm2=(**it2).nm;
-					if (pos1>net.size() || pos2>net.size()) {
-						cout<<"Nodes ids too high: "<<pos1<<" or "<<pos2<<endl;
-						cout.flush();
-						// cout<<" for nodes: "<<(**it1).nm<<" or "<<(**it2).nm<<endl;
-						cout.flush();
-						cout<<"Whole linkpack:"<<endl;
-						for (ittype fp = linkpack.begin(); fp != linkpack.end(); ++fp) {
-								cout<<(*fp)<<" ";
-								cout.flush();
-						}
-						cout<<"Whole toupdate list:"<<endl;
-						for (auto k = toupdate.begin(); k != toupdate.end(); k++) {
-								cout<<(**k).nm<<" "<<(**k).pos<<"|";
-								cout.flush();
-						}
-						cout<<endl;
-					}
-
-					if (pos1!=pos2) net[pos1][pos2]+=edgeincrement;
-					//net[pos1][pos1]+=edgeincrement; // this is done before
-				}
-			}
+			for (auto it1 = toupdate.begin(); it1 != toupdate.end(); it1++)
+				for (auto it2 = toupdate.begin(); it2 != toupdate.end(); it2++)
+					if (*it1!=*it2) net.add(*it1,*it2,edgeincrement);
 		}
 
 		myclockcollector->collect("TTTTaddedtostored");
@@ -239,7 +141,7 @@ public:
    // if (verbose>5) {
    // 	cout<<"add_linkpack: ";
    //    for (int i=0; i<10; i++)
-   //       cout<<names[i]<<" "<<net[i][i]<<" ";
+   //       cout<<nodenames.c_str(ids[i])<<" "<<net[i][i]<<" ";
    // }
 
 		//boost::this_thread::sleep(boost::posix_time::milliseconds(p_sleep));
@@ -248,59 +150,58 @@ public:
 	// no need to do anything, net_collector_base is already up-to-date
 	void update_net_collector_base () {}
 
-	// forgetting
+	// forgetting, scaling all strengths by the same factor
+	// keeps the order of the weakest nodes heap, with lazy forgetting
+	// only the shared unit of the stored weights is scaled
 	void forget_connections (double forgetfactor) {
-		minstr*=forgetfactor;
-		for (int i=0; i<net.size(); i++)
-			for (int j=0; j<net[i].size(); j++)
-				net[i][j]*=forgetfactor;
+		net.scale(forgetfactor);
+	}
+
+	// a node is held only while it is stored
+	void get_unused_ids (vector <unsigned> &unused) {
+		for (unsigned id=0; id<stored.size(); id++)
+			if (stored[id]==name_table::npos) unused.push_back(id);
 	}
 
 private:
 
 	void print_weakest() {
 		cout<<"Weakest:";
-		for (auto it=weakest.begin(); it!=weakest.end(); it++) {
-			auto pos=(*it);
-			cout<<" "<<names[pos]<<" "<<pos<<" "<<net[pos][pos]<<" | ";
+		if (!weakest.empty()) {
+			auto pos=weakest.top();
+			cout<<" "<<nodenames.c_str(ids[pos])<<" "<<pos<<" "<<net.get(pos,pos)<<" | ";
 		}
 		cout<<endl;
 	}
 
 	void print_stored() {
 		cout<<"Stored:";
-		for (auto it=stored.begin(); it!=stored.end(); it++) {
-			auto pos=it->pos;
-			cout<<" "<<it->nm<<" "<<names[pos]<<" "<<pos<<" "<<net[pos][pos]<<" | ";
-		}
+		for (unsigned pos=0; pos<nstored; pos++)
+			cout<<" "<<nodenames.c_str(ids[pos])<<" "<<pos<<" "<<net.get(pos,pos)<<" | ";
 		cout<<endl;
 	}
 
-	// in case of weakest empty find new weakest elements
-	void refill_weakest() {
-		if (weakest.size()==0) {
-			double currminstr=1e100;
-			for (auto it=stored.begin(); it!=stored.end(); it++) {
-				auto pos=it->pos;
-				if (net[pos][pos]<=currminstr) {
-					if (net[pos][pos]<currminstr) {
-						currminstr=net[pos][pos];
-						weakest.clear();
-						weakest.push_back(pos);
-					}
-					else weakest.push_back(pos);
-				}
-			}
-			minstr=currminstr;
+	// orders nodes by strength, older updates first among equal strengths;
+	// this tie-break differs from the one of earlier versions, which changes
+	// the events where the weakest nodes have equal strengths
+	struct weaker {
+		net_collector *nc;
+		weaker(net_collector *nc):nc(nc) {}
+		bool operator()(unsigned pos1, unsigned pos2) const {
+			double str1=nc->net.get(pos1,pos1), str2=nc->net.get(pos2,pos2);
+			if (str1!=str2) return str1<str2;
+			return nc->stamp[pos1]<nc->stamp[pos2];
 		}
-	}
+	};
 
-	set <node_base> stored; //stored nodes
-	deque <unsigned> weakest;
+	vector <unsigned> stored; //positions of the stored nodes indexed by their ids
+	vector <unsigned> toupdate; //positions of the nodes of the current linkpack
+	vector <unsigned long> stamp; //when the node was last updated
+	indexed_heap <weaker> weakest; //stored nodes, the weakest on top
 
 	clock_collectors *myclockcollector;
 
-	double minstr;
+	unsigned long laststamp;
 	unsigned nstored, verbose;
 };
 
@@ -8,52 +8,55 @@
 #include <vector>
 #include <unordered_map>
 
+#include <util/name_table.hpp>
+#include <viz/sparse_net.hpp>
+
 using namespace std;
 
 class net_collector_base {
 public:
 
-	net_collector_base (const unsigned maxstored)
-		:names(maxstored), net(maxstored, vector <double> (maxstored,0)),
-		maxstored(maxstored) {}
+	net_collector_base (const unsigned maxstored, const name_table &nodenames)
+		:maxstored(maxstored), nodenames(nodenames),
+		ids(maxstored, name_table::npos), net(maxstored) {}
 
 	void reset_collector_base_content () {
-		for (int i=0; i<net.size(); i++)
-			for (int j=0; j<net[i].size(); j++)
-				net[i][j]=0;
-		for (int i=0; i<names.size(); i++) names[i]="";
+		net.clear();
+		for (int i=0; i<ids.size(); i++) ids[i]=name_table::npos;
 	}
 
 
    double get_total_score() {
    	double result=0;
-		// for (int i=0; i<net.size(); i++)
-		// 	for (int j=0; j<net[i].size(); j++) if (i!=j)
-		// 		result += net[i][j];
-		for (int i=0; i<net.size(); i++) result += net[i][i];
+		for (int i=0; i<net.size(); i++) result += net.get(i,i);
 		return result;
    }
 
    void print_nodes(ofstream &ostream){
-		for (int i=0; i<names.size(); i++) if (names[i]!="")
-			ostream<<names[i]<<" ";
+		for (int i=0; i<ids.size(); i++) if (ids[i]!=name_table::npos)
+			ostream<<nodenames.c_str(ids[i])<<" ";
 		ostream<<endl;
    }
 
 	virtual unsigned get_nodes_number() {
    	unsigned result=0;
-		for (int i=0; i<names.size(); i++) if (names[i]!="") result++;
+		for (int i=0; i<ids.size(); i++) if (ids[i]!=name_table::npos) result++;
 		return result;
    }
 
    virtual void add_linkpack (
-   	vector <string> &linkpack, double weight, long ts, int verbose) = 0;
+   	vector <unsigned> &linkpack, double weight, long ts, int verbose) = 0;
    virtual void update_net_collector_base () = 0;
    virtual void forget_connections (double forgetfactor) = 0;
-
-	const unsigned maxstored; // 20000 corresponds to around 4gb of memory
-	vector <string> names;
-	vector <vector <double> > net;
+   // puts into unused the ids seen whose nodes the collector holds no
+   // more, and frees what it kept for them, so that the ids can be given
+   // to other names; called between the frames
+   virtual void get_unused_ids (vector <unsigned> &unused) = 0;
+
+	const unsigned maxstored;
+	const name_table &nodenames;
+	vector <unsigned> ids; // ids of the node names stored at each position
+	sparse_net net; // grows with the number of buffered links
 
 };
 
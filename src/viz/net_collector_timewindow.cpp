@@ -7,18 +7,21 @@
 #define VIZ_NET_COLLECTOR_TIMEWINDOW_HPP
 
 #include <cassert>
-#include <deque>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <vector>
-#include <list>
 #include <unordered_map>
 
 #include <pms/clock_collector.hpp>
+#include <util/indexed_heap.hpp>
+#include <util/ring_buffer.hpp>
 #include <viz/node.hpp>
 #include <viz/link.cpp>
 #include <viz/net_collector_base.hpp>
+#include <viz/window_net.hpp>
 
 using namespace std;
 
@@ -26,199 +29,253 @@ class net_collector_timewindow : public net_collector_base {
 public:
 
    net_collector_timewindow ( const unsigned maxstored,
+         const name_table &nodenames,
          const double timewindow, const double forgetconst, const string viztype,
-    		clock_collectors &mycc, unsigned verbose=1):
-            net_collector_base(maxstored),
+    		clock_collectors &mycc, unsigned verbose=1,
+         const size_t maxlinks=1e6, const double decaytolerance=0):
+            net_collector_base(maxstored, nodenames),
             timewindow(timewindow),
             forgetconst(forgetconst),
             verbose(verbose),
-            viztype(viztype) {
+            viztype(viztype),
+            maxlinks(maxlinks),
+            decay(viztype=="exptimewindow"),
+            weakest(0, weaker(this)),
+            strongest(0, stronger(this)),
+            arrived(0),
+            reftime(0),
+            unit(1) {
       myclockcollector=&mycc;
+      for (unsigned pos=maxstored; pos>0; pos--) freepos.push_back(pos-1);
+      net.set_lazy_scaling(decay);
+
+      // with the decay the links leave the window once their weight
+      // decayed below the tolerance times their original weight
+      horizon=timewindow;
+      if (decay) {
+         horizon=numeric_limits<double>::infinity();
+         if (decaytolerance>0 && forgetconst<1)
+            horizon=timewindow*( 0.5 + log(decaytolerance)/log(forgetconst) );
+      }
    }
 
-   void add_linkpack (vector <string> &linkpack, double weight, long ts, int verbose=0) {
+   void add_linkpack (vector <unsigned> &linkpack, double weight, long ts, int verbose=0) {
       for (int i=0; i<linkpack.size(); i++)
          for (int j=0; j<linkpack.size(); j++) if (i<j) {
-            string name1=linkpack[i];
-            string name2=linkpack[j];
-            link_timed l(name1, name2, weight, ts);
+            link_timed l(linkpack[i], linkpack[j], weight, ts);
             latest.push_back( l );
+            arrived++;
          }
    }
 
    unsigned get_nodes_number() {
-      return nodes_number;
+      return window.get_nodes_number();
    }
 
+   // brings the buffered subgraph up to date with the window, only the
+   // nodes whose links have entered or left the window since the last
+   // frame are visited
    void update_net_collector_base () {
-      string name1, name2;
-      long id1, id2, newid1, newid2;
-      double str1, str2;
-      double weight;
-
-      // reset the base collector
-    	reset_collector_base_content();
-      if (viztype=="exptimewindow")
-         apply_exp_decay();
-      else if (viztype=="timewindow")
-         apply_time_window();
-
-      // a method for encoding node's name
-      long lastassignedpos;
-      auto insert_to_namepos = [&]( string name,
-            unordered_map <string, long> &namepos) {
-         auto found = namepos.find(name);
-         if (found==namepos.end())
-            namepos[name]=(++lastassignedpos);
-      };
-
-      // get the strengths
-      unordered_map <string, long> namepos_all;
-      lastassignedpos=-1;
-      unordered_map <long, double> strengths;
-      for (auto it=latest.begin(); it!=latest.end(); it++) {
-         name1 = it->name1;
-         name2 = it->name2;
-         weight = it->weight;
-         insert_to_namepos(name1, namepos_all);
-         insert_to_namepos(name2, namepos_all);
-         id1 = namepos_all[name1];
-         id2 = namepos_all[name2];
-         strengths[id1] += weight;
-         strengths[id2] += weight;
-      }
-      nodes_number = namepos_all.size();
-
-      // sort the strengths
-      auto sort_second = [](
-            const pair<long, double> &lhs,
-            const pair<long, double> &rhs ) {
-         return lhs.second > rhs.second;
-      };
-      vector< pair<long, double> > strengths_sorted;
-      for (auto it=strengths.begin(); it!=strengths.end(); it++)
-         strengths_sorted.push_back(*it);
-      sort( strengths_sorted.begin(), strengths_sorted.end(), sort_second );
-
-      // get node's id by either creating it or finding it
-      auto addget_namepos = [&]( string name,
-            unordered_map <string, long> &namepos) {
-         auto found = namepos.find(name);
-         if (found==namepos.end()){
-            if (namepos.size()<maxstored) {
-               namepos[name]=(++lastassignedpos);
-               names[lastassignedpos] = name;
-               return lastassignedpos;
+      if (latest.empty()) return;
+      if (decay) apply_exp_decay();
+      apply_time_window();
+
+      // put the touched nodes back to the heaps of the buffered and of the
+      // waiting nodes, and update the buffered ones
+      for (unsigned k=0; k<touched.size(); k++) {
+         unsigned id=touched[k];
+         istouched[id]=false;
+         if (stored[id]!=name_table::npos) {
+            if (window.links(id)==0) unbuffer(id);
+            else {
+               net.clear_node(stored[id]);
+               fill_node(id);
+               weakest.push(id);
             }
-            else return (long)-1;
          }
-         else return namepos[name];
-      };
-
-      // fill the base collector with at most maxstored strongest nodes
-      // cout<<"1"; cout.flush();
-      unordered_map <string, long> namepos_buf;
-      lastassignedpos=-1;
-      long i_threshold;
-      if (strengths_sorted.size()>maxstored) i_threshold=maxstored;
-      else i_threshold=strengths_sorted.size()-1;
-      double str_threshold = strengths_sorted[i_threshold].second;
+         else if (window.links(id)>0) strongest.push(id);
+      }
+      touched.clear();
+
+      // keep at most maxstored strongest nodes in the buffer
+      while (weakest.size()<maxstored && !strongest.empty()) {
+         unsigned id=strongest.top();
+         strongest.pop();
+         buffer(id);
+      }
+      while (!strongest.empty() && !weakest.empty() &&
+            stronger(this)(strongest.top(), weakest.top())) {
+         unsigned out=weakest.top();
+         unsigned in=strongest.top();
+         weakest.pop();
+         unbuffer(out);
+         strongest.pop();
+         strongest.push(out);
+         buffer(in);
+      }
+
       if (verbose>3) {
-         cout<<"strengths_sorted:"<<endl;
-         for (auto i=0; i<strengths_sorted.size(); i++)
-            cout<<strengths_sorted[i].first<<" "
-                <<strengths_sorted[i].second<<" ";
+         cout<<"buffered strengths:"<<endl;
+         for (auto i=0; i<weakest.size(); i++)
+            cout<<nodenames.c_str(weakest.elements()[i])<<" "
+                <<unit*window.strength(weakest.elements()[i])<<" ";
          cout<<endl;
       }
-      // cout<<"2"; cout.flush();
-      for (auto it=latest.begin(); it!=latest.end(); it++) {
-         // cout<<"3"; cout.flush();
-         name1 = it->name1;
-         name2 = it->name2;
-         weight = it->weight;
-         id1 = namepos_all[name1];
-         id2 = namepos_all[name2];
-         str1 = strengths[id1];
-         str2 = strengths[id2];
-         newid1=newid2=-1;
-         // cout<<"4"; cout.flush();
-         if ( str1>=str_threshold ) {
-            newid1 = addget_namepos(name1, namepos_buf);
-            if (newid1>=0) net[newid1][newid1] += weight;
-         }
-         // cout<<"5"; cout.flush();
-         if ( str2>=str_threshold ) {
-            newid2 = addget_namepos(name2, namepos_buf);
-            if (newid2>=0) net[newid2][newid2] += weight;
-         }
-         // cout<<"6"; cout.flush();
-         if ( newid1>=0 && newid2>=0 ) {
-            net[newid1][newid2] += weight;
-            net[newid2][newid1] += weight;
-         }
-      }
-      // cout<<"9"; cout.flush();
    }
 
    // no forgetting for this method
    void forget_connections (double forgetfactor) {}
 
-private:
-
-   // a fast pow, about 3 times faster than pow
-   inline double fastpow(double a, double b) {
-     // calculate approximation with fraction of the exponent
-     int e = (int) b;
-     union {
-       double d;
-       int x[2];
-     } u = { a };
-     u.x[1] = (int)((b - e) * (u.x[1] - 1072632447) + 1072632447);
-     u.x[0] = 0;
-
-     // exponentiation by squaring with the exponent's integer part
-     // double r = u.d makes everything much slower, not sure why
-     double r = 1.0;
-     while (e) {
-       if (e & 1) {
-         r *= a;
-       }
-       a *= a;
-       e >>= 1;
-     }
-
-     return r * u.d;
+   // a node is held while it is buffered or has links in the window, all
+   // the links have entered the window between the frames
+   void get_unused_ids (vector <unsigned> &unused) {
+      for (unsigned id=0; id<stored.size(); id++)
+         if (stored[id]==name_table::npos
+               && (id>=window.size() || window.links(id)==0)) {
+            if (id<window.size()) window.forget(id);
+            unused.push_back(id);
+         }
    }
 
-   void apply_exp_decay () {
-      // keep the size of the list smaller than the given number of links
-      const int maxlinks = 1e6;
-      // const int maxlinks = 2e5;
-      if (latest.size()>maxlinks) {
-         int i=0;
-         auto limitingit = latest.begin();
-         while( i<latest.size()-maxlinks ) { limitingit++; i++; }
-         latest.erase( latest.begin(), limitingit );
-      }
+private:
 
-      // modify weight to account for eponential decay
+   // The weight of a link decays as forgetconst^(age/timewindow-0.5).
+   // The window keeps the weights decayed to reftime, which for a newer
+   // link is a growth, and the decay from reftime to now is one factor
+   // shared by all weights. It becomes the unit of the buffered weights,
+   // which is a single multiplication of the unit per frame.
+   void apply_exp_decay () {
       long latesttime=latest.back().ts;
-      double invtimewindow = 1.0/timewindow;
-      for (auto it=latest.begin(); it!=latest.end(); it++) {
-         long timepassed = latesttime - it->ts;
-         double decayfactor = pow( forgetconst,
-            invtimewindow * ( timepassed  - timewindow*0.5 ) );
-         it->weight = it->orgweigth * decayfactor;
+      if (window.get_nodes_number()==0) reftime=latesttime;
+
+      // move reftime to now before the weights of the new links overflow
+      double exponent = (latesttime-reftime)/timewindow*log(forgetconst);
+      // the nodes are put to the heaps again in case some strengths
+      // underflow and their order changes
+      if (fabs(exponent)>200) {
+         for (unsigned k=0; k<weakest.size(); k++) touch(weakest.elements()[k]);
+         for (unsigned k=0; k<strongest.size(); k++)
+            touch(strongest.elements()[k]);
+         take_from_heaps();
+         window.scale(exp(exponent));
+         reftime=latesttime;
       }
+
+      double newunit = pow( forgetconst,
+         (latesttime-reftime)/timewindow - 0.5 );
+      net.scale(newunit/unit);
+      unit=newunit;
+   }
+
+   // weight of the link in the window
+   double get_weight (const link_timed &l) {
+      if (!decay) return l.weight;
+      return l.weight*pow( forgetconst, (reftime-l.ts)/timewindow );
    }
 
+   // the links that arrived since the last frame enter the window, and
+   // the links older than the horizon or over the memory budget leave it
    void apply_time_window () {
       long latesttime=latest.back().ts;
-      list<link_timed>::iterator limitingit=latest.begin();
-      while(latesttime - limitingit->ts > timewindow) limitingit++;
-      latest.erase(latest.begin(), limitingit);
+      size_t expired=0;
+      if (latest.size()>maxlinks) expired=latest.size()-maxlinks;
+      while(expired<latest.size() && latesttime - latest[expired].ts > horizon)
+         expired++;
+      size_t firstarrived=latest.size()-arrived;
+
+      for (size_t i=firstarrived; i<latest.size(); i++) {
+         touch(latest[i].id1);
+         touch(latest[i].id2);
+      }
+      for (size_t i=0; i<expired; i++) {
+         touch(latest[i].id1);
+         touch(latest[i].id2);
+      }
+      take_from_heaps();
+
+      for (size_t i=firstarrived; i<latest.size(); i++)
+         window.add_link(latest[i].id1, latest[i].id2, get_weight(latest[i]));
+      for (size_t i=0; i<expired; i++)
+         window.remove_link(latest[i].id1, latest[i].id2, get_weight(latest[i]));
+      latest.pop_front(expired);
+      arrived=0;
+   }
+
+   void touch (unsigned id) {
+      if (id>=istouched.size()) {
+         istouched.resize(id+1, false);
+         stored.resize(id+1, name_table::npos);
+         weakest.resize(id+1);
+         strongest.resize(id+1);
+      }
+      if (!istouched[id]) {
+         istouched[id]=true;
+         touched.push_back(id);
+      }
+   }
+
+   // the strengths of the touched nodes are going to change, so they
+   // leave the heaps before the window is modified
+   void take_from_heaps () {
+      for (unsigned k=0; k<touched.size(); k++) {
+         unsigned id=touched[k];
+         if (weakest.contains(id)) weakest.remove(id);
+         else if (strongest.contains(id)) strongest.remove(id);
+      }
    }
 
+   // sets the strength of the buffered node and its links
+   // to the other buffered nodes
+   void fill_node (unsigned id) {
+      unsigned pos=stored[id];
+      net.set(pos,pos,unit*window.strength(id));
+      for (auto it=window.row(id).begin(); it!=window.row(id).end(); it++) {
+         unsigned otherpos=stored[it->first];
+         if (otherpos!=name_table::npos) {
+            net.set(pos,otherpos,unit*it->second.weight);
+            net.set(otherpos,pos,unit*it->second.weight);
+         }
+      }
+   }
+
+   // puts the node into a free position of the buffer
+   void buffer (unsigned id) {
+      unsigned pos=freepos.back();
+      freepos.pop_back();
+      stored[id]=pos;
+      ids[pos]=id;
+      fill_node(id);
+      weakest.push(id);
+   }
+
+   // frees the buffer position of a node that is not in the heap
+   void unbuffer (unsigned id) {
+      unsigned pos=stored[id];
+      net.clear_node(pos);
+      ids[pos]=name_table::npos;
+      stored[id]=name_table::npos;
+      freepos.push_back(pos);
+   }
+
+   // orders nodes of the window by strength, lower ids first among
+   // equal strengths
+   struct stronger {
+      net_collector_timewindow *nc;
+      stronger(net_collector_timewindow *nc):nc(nc) {}
+      bool operator()(unsigned id1, unsigned id2) const {
+         double str1=nc->window.strength(id1), str2=nc->window.strength(id2);
+         if (str1!=str2) return str1>str2;
+         return id1<id2;
+      }
+   };
+   struct weaker {
+      net_collector_timewindow *nc;
+      weaker(net_collector_timewindow *nc):nc(nc) {}
+      bool operator()(unsigned id1, unsigned id2) const {
+         return stronger(nc)(id2, id1);
+      }
+   };
+
 private:
 
    const double timewindow;
@@ -226,9 +283,21 @@ private:
    const unsigned verbose;
    const string viztype;
 
-   list <link_timed> latest;
+   ring_buffer <link_timed> latest; // links in the order of arrival
+   const size_t maxlinks; // the memory budget of latest
+   const bool decay; // exponential decay of the weights
+   double horizon; // age of the links leaving the window
+   window_net window; // aggregated links of the window
+   vector <unsigned> stored; // buffer positions of the nodes indexed by ids
+   vector <unsigned> freepos; // free buffer positions
+   indexed_heap <weaker> weakest; // buffered nodes, the weakest on top
+   indexed_heap <stronger> strongest; // other nodes, the strongest on top
+   vector <unsigned> touched; // nodes whose links changed since last frame
+   vector <bool> istouched;
+   unsigned arrived; // links added since the last frame
+   long reftime; // time to which the weights in the window are decayed
+   double unit; // decay of the window weights from reftime to now
    clock_collectors *myclockcollector;
-   unsigned nodes_number;
 };
 
 
@@ -0,0 +1,303 @@
+/*
+ * Statistics of a subgraph of the buffered network, computed directly on
+ * the sparse adjacency of the collector
+ *
+ * The subgraph is induced by a set of positions, its links are the stored
+ * non-zero off-diagonal weights between them. The local triangle counts,
+ * which dominate the cost, are computed by several threads over disjoint
+ * sets of nodes, each thread with its own marks of the neighbours.
+ *
+ * The statistics of the whole buffered network are instead kept up to
+ * date by net_stats_tracker, which follows the links added to and removed
+ * from the network, so that they can be read on every frame.
+ */
+
+#ifndef VIZ_NET_STATS_HPP
+#define VIZ_NET_STATS_HPP
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <viz/sparse_net.hpp>
+
+using namespace std;
+
+struct netstats {
+   double avgdeg, avgstr; // average degree and strength
+   double ccglo, ccloc; // global and average local clustering coefficient
+   double assdeg, assstr; // degree and strength assortativity
+};
+
+class net_stats {
+public:
+
+   // the nodes are the positions of the subgraph in the network
+   net_stats (const sparse_net &net, const vector <unsigned> &nodes)
+      :net(net), nodes(nodes), index(net.size(), -1),
+       deg(nodes.size()), str(nodes.size()), tri(nodes.size()) {
+      for (unsigned k=0; k<nodes.size(); k++) index[nodes[k]] = k;
+   }
+
+   // links between the neighbours of the node of the given index, once
+   // computed
+   unsigned long triangles (unsigned k) const { return tri[k]; }
+
+   // nodes of degree lower than 2 have a local clustering of 0, as do
+   // the assortativities that are not defined
+   netstats compute (unsigned threads=0) {
+      netstats result = {0, 0, 0, 0, 0, 0};
+      unsigned n = nodes.size();
+      if (n==0) return result;
+
+      if (threads==0) threads = thread::hardware_concurrency();
+      threads = max(1u, min(threads, 1+n/minnodes));
+      vector <thread> workers;
+      for (unsigned t=1; t<threads; t++)
+         workers.push_back(thread(&net_stats::count, this, t, threads));
+      count(0, threads);
+      for (unsigned t=0; t<workers.size(); t++) workers[t].join();
+
+      double triples = 0, triangles = 0;
+      for (unsigned k=0; k<n; k++) {
+         result.avgdeg += deg[k];
+         result.avgstr += str[k];
+         double pairs = 0.5*deg[k]*(deg[k]-1.0);
+         triples += pairs;
+         triangles += tri[k];
+         if (deg[k]>=2) result.ccloc += tri[k]/pairs;
+      }
+      result.avgdeg /= n;
+      result.avgstr /= n;
+      result.ccloc /= n;
+      if (triples>0) result.ccglo = triangles/triples;
+      result.assdeg = assortativity(deg);
+      result.assstr = assortativity(str);
+      return result;
+   }
+
+private:
+
+   static const unsigned minnodes = 256; // nodes per thread at least
+
+   // degree, strength and the links between the neighbours of every
+   // threads-th node from the first one
+   void count (unsigned first, unsigned threads) {
+      double unit = net.get_unit();
+      vector <char> mark(nodes.size(), 0);
+      vector <unsigned> neighbours;
+      for (unsigned k=first; k<nodes.size(); k+=threads) {
+         neighbours.clear();
+         double s = 0;
+         const sparse_net::row_type &row = net.row(nodes[k]);
+         for (sparse_net::row_type::const_iterator it=row.begin();
+               it!=row.end(); it++) {
+            int b = index[it->first];
+            if (b<0 || !it->second || b==(int)k) continue;
+            neighbours.push_back(b);
+            mark[b] = 1;
+            s += it->second*unit;
+         }
+         deg[k] = neighbours.size();
+         str[k] = s;
+
+         // each link between two neighbours is found from both of them
+         unsigned long links = 0;
+         for (unsigned v=0; v<neighbours.size(); v++) {
+            const sparse_net::row_type &vrow = net.row(nodes[neighbours[v]]);
+            for (sparse_net::row_type::const_iterator it=vrow.begin();
+                  it!=vrow.end(); it++) {
+               int b = index[it->first];
+               if (b>=0 && it->second && mark[b]) links++;
+            }
+         }
+         tri[k] = links/2;
+         for (unsigned v=0; v<neighbours.size(); v++) mark[neighbours[v]] = 0;
+      }
+   }
+
+   // Pearson correlation of the values at both ends of the links
+   double assortativity (const vector <double> &value) {
+      double pairs = 0, sumxy = 0, sumx = 0, sumx2 = 0;
+      for (unsigned k=0; k<nodes.size(); k++) {
+         const sparse_net::row_type &row = net.row(nodes[k]);
+         for (sparse_net::row_type::const_iterator it=row.begin();
+               it!=row.end(); it++) {
+            int b = index[it->first];
+            if (b<0 || !it->second || b==(int)k) continue;
+            pairs++;
+            sumxy += value[k]*value[b];
+            sumx += value[k];
+            sumx2 += value[k]*value[k];
+         }
+      }
+      if (pairs==0) return 0;
+      double mean = sumx/pairs;
+      double variance = sumx2/pairs-mean*mean;
+      if (variance<=1e-12*sumx2/pairs) return 0;
+      return (sumxy/pairs-mean*mean)/variance;
+   }
+
+   const sparse_net &net;
+   const vector <unsigned> &nodes;
+   vector <int> index; // index of the node at each position, or -1
+   vector <double> deg, str;
+   vector <unsigned long> tri; // links between the neighbours of the node
+};
+
+// Follows the links of the network and keeps the degrees, the triangles
+// at each node and the sums giving the average degree and the clustering
+// coefficients. A link costs the shorter row of its two nodes when it is
+// added or removed. The weights change at every frame, so only their
+// total is kept by the network, and the assortativities take one pass
+// over the links when they are read.
+class net_stats_tracker : public sparse_net_observer {
+public:
+
+   net_stats_tracker (sparse_net &net)
+      :net(net) {
+      rebuild();
+      net.set_observer(this);
+   }
+
+   ~net_stats_tracker () { net.set_observer(0); }
+
+   // statistics of the network with the given number of nodes
+   netstats get (unsigned nodes) const {
+      netstats result = {0, 0, 0, 0, 0, 0};
+      if (nodes==0) return result;
+      result.avgdeg = 2.0*links/nodes;
+      result.avgstr = net.link_weights()/nodes;
+      if (triples>0) result.ccglo = triangles/triples;
+      result.ccloc = max(0.0, ccsum)/nodes;
+      assortativities(result.assdeg, result.assstr);
+      return result;
+   }
+
+   void link_added (unsigned i, unsigned j) {
+      double before = cc(i)+cc(j);
+      triples += deg[i]+deg[j];
+      deg[i]++;
+      deg[j]++;
+      change_triangles(i, j, 1);
+      ccsum += cc(i)+cc(j)-before;
+      links++;
+   }
+
+   void link_removed (unsigned i, unsigned j) {
+      double before = cc(i)+cc(j);
+      change_triangles(i, j, -1);
+      deg[i]--;
+      deg[j]--;
+      triples -= deg[i]+deg[j];
+      ccsum += cc(i)+cc(j)-before;
+      links--;
+   }
+
+   void cleared () {
+      deg.assign(net.size(), 0);
+      tri.assign(net.size(), 0);
+      links = 0;
+      triples = triangles = ccsum = 0;
+   }
+
+private:
+
+   // local clustering coefficient of the node
+   double cc (unsigned i) const {
+      return deg[i]>=2 ? tri[i]/(0.5*deg[i]*(deg[i]-1.0)) : 0;
+   }
+
+   // the triangles closed by the link between i and j, going through the
+   // shorter row of the two
+   void change_triangles (unsigned i, unsigned j, int change) {
+      unsigned a = i, b = j;
+      if (net.row(a).size()>net.row(b).size()) swap(a,b);
+      const sparse_net::row_type &row = net.row(a);
+      for (sparse_net::row_type::const_iterator it=row.begin();
+            it!=row.end(); it++) {
+         unsigned w = it->first;
+         // most of the nodes are not in the other row, they are left first
+         if (w==b || !net.row(b).count(w) || !net.linked(a,w)
+               || !net.row(w).count(b)) continue;
+         ccsum -= cc(w);
+         tri[w] += change;
+         ccsum += cc(w);
+         tri[i] += change;
+         tri[j] += change;
+         triangles += 3*change;
+      }
+   }
+
+   // the links that are already stored when the tracker starts
+   void rebuild () {
+      cleared();
+      vector <unsigned> nodes;
+      for (unsigned i=0; i<net.size(); i++) nodes.push_back(i);
+      net_stats counts(net, nodes);
+      counts.compute();
+      for (unsigned i=0; i<net.size(); i++) {
+         const sparse_net::row_type &row = net.row(i);
+         for (sparse_net::row_type::const_iterator it=row.begin();
+               it!=row.end(); it++)
+            if (net.linked(i,it->first)) deg[i]++;
+         links += deg[i];
+         tri[i] = counts.triangles(i);
+         triples += 0.5*deg[i]*(deg[i]-1.0);
+         triangles += tri[i];
+         ccsum += cc(i);
+      }
+      links /= 2;
+   }
+
+   // Pearson correlations of the degrees and of the strengths at both
+   // ends of the links
+   void assortativities (double &assdeg, double &assstr) const {
+      vector <double> &s = strengths;
+      s.assign(net.size(), 0);
+      for (unsigned i=0; i<net.size(); i++) {
+         const sparse_net::row_type &row = net.row(i);
+         for (sparse_net::row_type::const_iterator it=row.begin();
+               it!=row.end(); it++)
+            s[i] += it->second;
+      }
+      double ends = 0, degprod = 0, strprod = 0;
+      double degsum = 0, degsq = 0, strsum = 0, strsq = 0;
+      for (unsigned i=0; i<net.size(); i++) {
+         const sparse_net::row_type &row = net.row(i);
+         for (sparse_net::row_type::const_iterator it=row.begin();
+               it!=row.end(); it++) {
+            degprod += (double)row.size()*net.row(it->first).size();
+            strprod += s[i]*s[it->first];
+         }
+         double d = row.size();
+         ends += d;
+         degsum += d*d;
+         degsq += d*d*d;
+         strsum += d*s[i];
+         strsq += d*s[i]*s[i];
+      }
+      assdeg = pearson(ends, degprod, degsum, degsq);
+      assstr = pearson(ends, strprod, strsum, strsq);
+   }
+
+   // Pearson correlation of the values at both ends of the links, from
+   // the sums over the ends of the products, values and squared values
+   static double pearson (double ends, double products, double values,
+         double squares) {
+      if (ends==0) return 0;
+      double mean = values/ends;
+      double variance = squares/ends-mean*mean;
+      if (variance<=1e-12*squares/ends) return 0;
+      return (products/ends-mean*mean)/variance;
+   }
+
+   sparse_net &net;
+   vector <unsigned> deg;
+   vector <long> tri; // links between the neighbours of the node
+   unsigned long links;
+   double triples, triangles, ccsum; // sums over the nodes
+   mutable vector <double> strengths;
+};
+
+#endif
@@ -5,20 +5,22 @@
 #ifndef VIZ_NODE_HPP
 #define VIZ_NODE_HPP
 
-#include <string>
+#include <algorithm>
+#include <vector>
+
+#include <util/name_table.hpp>
+
 using namespace std;
 
 struct node_base {
-  string nm; //name
+  unsigned id; //id of the name in the name_table
   unsigned pos; //position
   
-  node_base() {nm=""; pos=-1; }
-  node_base(string name, unsigned position) {nm=name; pos=position;}
+  node_base() {id=name_table::npos; pos=-1; }
+  node_base(unsigned id, unsigned position) {this->id=id; pos=position;}
   
-  bool operator<(const node_base &other) const {return nm<other.nm;}
-  bool operator==(const node_base &other) const {return nm==other.nm;}
-  bool operator<(const string &other) const {return nm<other;}
-  bool operator==(const string &other) const {return nm==other;}
+  bool operator<(const node_base &other) const {return id<other.id;}
+  bool operator==(const node_base &other) const {return id==other.id;}
 };
 
 struct node_the:node_base {
@@ -26,20 +28,36 @@ struct node_the:node_base {
   unsigned long time;
   
   node_the():node_base() {str=0; time=0; }
-  node_the(string name, unsigned position, double strength, unsigned timestamp)
-		:node_base(name, position){	  
+  node_the(unsigned id, unsigned position, double strength, unsigned timestamp)
+		:node_base(id, position){	  
 	  str=strength; time=timestamp;
   }
   
-  bool operator<(const node_the &other) const {return nm<other.nm;}
-  bool operator==(const node_the &other) const {return nm==other.nm;}
-  bool operator<(const string &other) const {return nm<other;}
-  bool operator==(const string &other) const {return nm==other;}
+  bool operator<(const node_the &other) const {return id<other.id;}
+  bool operator==(const node_the &other) const {return id==other.id;}
 };
 
 
 template <class T0>
 bool compare_node_strength ( T0 i, T0 j) { return (i.str<j.str); }
 
+// stronger nodes first, nodes of equal strength by their name id
+template <class T0>
+bool compare_node_stronger (const T0 &i, const T0 &j) {
+  return i.str>j.str || (i.str==j.str && i.id<j.id);
+}
+
+// keeps the k strongest nodes sorted by their name id, in O(n + k log k)
+// instead of sorting all the nodes by strength
+template <class T0>
+void select_strongest (vector <T0> &nodes, unsigned k) {
+  if (nodes.size()>k) {
+	 nth_element( nodes.begin(), nodes.begin()+k, nodes.end(),
+					  compare_node_stronger<T0> );
+	 nodes.resize(k);
+  }
+  sort( nodes.begin(), nodes.end() );
+}
+
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Sparse symmetric adjacency of the buffered subgraph, node strengths are
+ * kept on the diagonal, memory grows with the number of stored links
+ *
+ * With lazy scaling all weights are stored in a unit shared by all of them,
+ * so scaling the whole network is a single multiplication of the unit.
+ * The stored values are renormalised when the unit drifts too far from 1.
+ *
+ * An observer can follow the links, a link exists once both of its
+ * directions are stored, and the total weight of the links is kept.
+ */
+
+#ifndef VIZ_SPARSE_NET_HPP
+#define VIZ_SPARSE_NET_HPP
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class sparse_net_observer {
+public:
+   virtual ~sparse_net_observer () {}
+   // once both directions of the link are stored
+   virtual void link_added (unsigned i, unsigned j) = 0;
+   // before the link is removed
+   virtual void link_removed (unsigned i, unsigned j) = 0;
+   virtual void cleared () = 0;
+};
+
+class sparse_net {
+public:
+
+   typedef unordered_map <unsigned, double> row_type;
+
+   sparse_net (const unsigned size, bool lazy=false)
+      :diag(size,0), rows(size), unit(1), linksum(0), lazy(lazy),
+       observer(0) {}
+
+   void set_observer (sparse_net_observer *observer) {
+      this->observer = observer;
+   }
+
+   void set_lazy_scaling (bool lazy) {
+      renormalize();
+      this->lazy = lazy;
+   }
+
+   unsigned size() const { return diag.size(); }
+
+   // weight of the link between i and j, strength of the node if i==j
+   double get (unsigned i, unsigned j) const {
+      if (i==j) return diag[i]*unit;
+      const row_type &r = rows[i];
+      row_type::const_iterator found = r.find(j);
+      if (found==r.end()) return 0;
+      return found->second*unit;
+   }
+
+   void set (unsigned i, unsigned j, double weight) {
+      if (i==j) diag[i] = weight/unit;
+      else {
+         pair <row_type::iterator, bool> entry =
+            rows[i].insert(row_type::value_type(j,0));
+         linksum += weight/unit-entry.first->second;
+         entry.first->second = weight/unit;
+         if (entry.second) stored(i,j);
+      }
+   }
+
+   void add (unsigned i, unsigned j, double weight) {
+      if (i==j) diag[i] += weight/unit;
+      else {
+         pair <row_type::iterator, bool> entry =
+            rows[i].insert(row_type::value_type(j,0));
+         entry.first->second += weight/unit;
+         linksum += weight/unit;
+         if (entry.second) stored(i,j);
+      }
+   }
+
+   // both directions of the link are stored
+   bool linked (unsigned i, unsigned j) const {
+      return rows[i].count(j) && rows[j].count(i);
+   }
+
+   // total weight of the off-diagonal entries, each link is counted twice
+   double link_weights () const { return linksum*unit; }
+
+   // off-diagonal links of the node i, the weights are expressed
+   // in the stored unit and have to be multiplied by get_unit()
+   const row_type& row (unsigned i) const { return rows[i]; }
+   double get_unit () const { return unit; }
+
+   // removes all links of the node, links are assumed to be stored
+   // symmetrically so that only rows of its neighbours need to be touched
+   void clear_node (unsigned i) {
+      for (row_type::iterator it=rows[i].begin(); it!=rows[i].end(); it++) {
+         row_type::iterator back = rows[it->first].find(i);
+         if (back==rows[it->first].end()) continue;
+         if (observer) observer->link_removed(i, it->first);
+         linksum -= back->second;
+         rows[it->first].erase(back);
+      }
+      for (row_type::iterator it=rows[i].begin(); it!=rows[i].end(); it++)
+         linksum -= it->second;
+      row_type().swap(rows[i]);
+      diag[i] = 0;
+   }
+
+   void clear () {
+      for (unsigned i=0; i<rows.size(); i++) row_type().swap(rows[i]);
+      fill(diag.begin(), diag.end(), 0);
+      unit = 1;
+      linksum = 0;
+      if (observer) observer->cleared();
+   }
+
+   void scale (double factor) {
+      unit *= factor;
+      if (!lazy || unit<1e-100 || unit>1e100) renormalize();
+   }
+
+   // number of stored off-diagonal entries, each link is counted twice
+   size_t entries () const {
+      size_t result = 0;
+      for (unsigned i=0; i<rows.size(); i++) result += rows[i].size();
+      return result;
+   }
+
+private:
+
+   // expresses all the stored weights in the unit equal to 1, the total
+   // weight is summed again so that it does not drift
+   void renormalize () {
+      if (unit==1) return;
+      linksum = 0;
+      for (unsigned i=0; i<rows.size(); i++) {
+         diag[i] *= unit;
+         for (row_type::iterator it=rows[i].begin(); it!=rows[i].end(); it++) {
+            it->second *= unit;
+            linksum += it->second;
+         }
+      }
+      unit = 1;
+   }
+
+   // a new entry completes a link if the other direction is stored
+   void stored (unsigned i, unsigned j) {
+      if (observer && rows[j].count(i)) observer->link_added(i, j);
+   }
+
+   vector <double> diag;
+   vector <row_type> rows;
+   double unit;
+   double linksum; // in the stored unit
+   bool lazy;
+   sparse_net_observer *observer;
+};
+
+#endif
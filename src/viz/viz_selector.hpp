@@ -7,14 +7,14 @@
 
 #include <cmath>
 #include <list>
-#include <set>
+#include <memory>
 #include <vector>
 
-#include <igraph.h>
-
-#include <pms/std_to_igraph.cpp>
 #include <pms/clock_collector.hpp>
+#include <util/distinct_counter.hpp>
 #include <viz/client.hpp>
+#include <viz/edge_id_map.hpp>
+#include <viz/net_stats.hpp>
 #include <viz/node.hpp>
 #include <viz/net_collector.hpp>
 
@@ -23,7 +23,8 @@ using namespace std;
 class viz_selector_base {
 public:
 	virtual void draw (const unsigned maxvisualized, double edgeminweight,
-                      string excluded="", bool hide_singletons=true) {};
+                      unsigned excluded=name_table::npos,
+                      bool hide_singletons=true) {};
 
 	void add_labels(string datetime="",
                    string label1="",
@@ -55,47 +56,35 @@ public:
 
 protected:
 
-   // create a list of all stored nodes sorted by strength and select the strongest
+   // select the strongest stored nodes, sorted by their name id
 	template <class T0>
 	void select_nodes(net_collector_base *netcol, const unsigned maxvisualized,
 							vector <T0> &vntmp, double edgeminweight,
-							string excluded="", bool hide_singletons=true ) {
-		// get all buffered nodes and sort them by strength
-		vector<T0> bnodes;
+							unsigned excluded=name_table::npos, bool hide_singletons=true ) {
+		// get all buffered nodes and keep the strongest ones
+		vector<T0> bnstrongest;
 		T0 tmpnode;
-		for (int i=0; i<netcol->maxstored; i++) if (netcol->names[i]!="") {
-         tmpnode.nm=netcol->names[i];
+		for (int i=0; i<netcol->maxstored; i++) if (netcol->ids[i]!=name_table::npos) {
+         tmpnode.id=netcol->ids[i];
 			tmpnode.pos=i;
-			tmpnode.str=netcol->net[i][i];
-			bnodes.push_back(tmpnode);
+			tmpnode.str=netcol->net.get(i,i);
+			bnstrongest.push_back(tmpnode);
 		}
-		sort ( bnodes.begin(), bnodes.end(), compare_node_strength<T0> );
-  		// debugging
-		// if (verbose>4){
-		// 	for (int i=0; i<bnodes.size(); i++)
-		// 		cout<<bnodes[i].nm<<" "<<
-		// 			 netcol->net[bnodes[i].pos][bnodes[i].pos]<<" ";
-		// 	cout<<endl;
-		// 	for (int i=0; i<10; i++)
-		// 		cout<<netcol->names[i]<<" "<<netcol->net[i][i]<<" ";
-		// }
-
-		// select strongest nodes
-		unsigned currvisualized;
-		if (bnodes.size()>maxvisualized) currvisualized=maxvisualized;
-		else currvisualized=bnodes.size();
-		{vector <T0> bnstrongest(bnodes.end()-currvisualized,bnodes.end());
-
-		// filter out singletons, and late excluded node
+		select_strongest( bnstrongest, maxvisualized );
+
+		// filter out singletons, and late excluded node; the selected nodes
+		// are sorted by name id, as needed to compare with previous state
 		nodes_visualized=nodes_not_visualized=total_score=0;
+		mark_positions( netcol, bnstrongest, extract_position<T0> );
 		for (int i=0; i<bnstrongest.size(); i++) {
 			int edges=0;
-			for (int j=0; j<bnstrongest.size(); j++) if (i!=j) {
-				double weight = netcol->net[bnstrongest[i].pos][bnstrongest[j].pos];
+			linked_nodes( netcol, bnstrongest, i, false, extract_position<T0> );
+			for (int k=0; k<linked.size(); k++) {
+				double weight = netcol->net.get(bnstrongest[i].pos,bnstrongest[linked[k]].pos);
 				total_score+=weight;
 				edges+=(weight>edgeminweight);
 			}
-			if ( bnstrongest[i].nm!=excluded ) {
+			if ( bnstrongest[i].id!=excluded ) {
 				if (hide_singletons) {
 					if (edges>0) {
 						vntmp.push_back(bnstrongest[i]);
@@ -109,23 +98,16 @@ protected:
 				}
 			}
 			else nodes_not_visualized++;
-		}}
-
-		// sort according to the name in order to compare with previous state
-		sort ( vntmp.begin(), vntmp.end() );
+		}
+		unmark_positions( bnstrongest, extract_position<T0> );
 	}
 
 
    // clears ids of the edges removed from the visualization
-   // eidm is a matrix of size of net matrix, to save processor time,
-   // it could be implemented differently, now it's very memory expensive
 	template <class T0, class T1>
 	static void clean_edgeids(T0 &prevvisn, T1 &eidm,
 			typename T0::iterator &node_deleted) {
-		for (int i=0; i<prevvisn.size(); i++) {
-			eidm[node_deleted->pos][prevvisn[i].pos]=0;
-			eidm[prevvisn[i].pos][node_deleted->pos]=0;
-		}
+		eidm.clear_node(node_deleted->pos);
 	}
 
    // makes differential comparison of prevvisn and vntmp,
@@ -141,21 +123,22 @@ protected:
 		first1=prevvisn.begin(); last1=prevvisn.end();
 		first2=vntmp.begin(); last2=vntmp.end();
 		// layout - red/blue
-		//oc->set_attributes("r",1, "g",0.5, "b",0.5, "label",(*first2).nm);
+		//oc->set_attributes("r",1, "g",0.5, "b",0.5, "label",name(*first2));
 		// layout - yellow/blue
-		//oc->set_attributes("r",1, "g",1, "b",0, "label",(*first2).nm);
+		//oc->set_attributes("r",1, "g",1, "b",0, "label",name(*first2));
 		while (first1!=last1 && first2!=last2)
 		{
          // remove node from visualization
-			if ((*first1).nm<(*first2).nm) {
-				oc->delete_node((*first1).nm);
+			if ((*first1).id<(*first2).id) {
+				oc->delete_node(name(*first1));
 				cleaner_function(prevvisn, eidm, first1);
 				++first1;
 			}
          // add node and all its edges to visualization
-			else if ((*first2).nm<(*first1).nm) {
-				oc->set_attributes("r",1, "g",1, "b",0, "label",(*first2).nm);
-				oc->add_node((*first2).nm);
+			else if ((*first2).id<(*first1).id) {
+				oc->set_attributes("r",1, "g",1, "b",0, "label",name(*first2));
+				oc->add_node(name(*first2));
+				forget_shown_size(first2->pos);
 				++first2;
 			}
          // update outgoing edge weights of the node
@@ -165,28 +148,38 @@ protected:
 		}
       // remove node from visualization
 		while (first1!=last1) {
-			oc->delete_node((*first1).nm);
+			oc->delete_node(name(*first1));
 			cleaner_function(prevvisn, eidm, first1);
 			++first1;
 		}
       // add node and all its edges to visualization
 		while (first2!=last2) {
-			oc->set_attributes("r",1, "g",1, "b",0, "label",(*first2).nm);
-			oc->add_node((*first2).nm);
+			oc->set_attributes("r",1, "g",1, "b",0, "label",name(*first2));
+			oc->add_node(name(*first2));
+			forget_shown_size(first2->pos);
 			++first2;
 		}
 	}
 
-   // sends to the output client changes in node sizes and colors
+   // sends to the output client changes in node sizes and colors, a node
+   // is sent once it is added and then when its size changes by more than
+   // the change tolerance
 	template <class T0>
-	void change_nodes(net_collector_base *netcol, T0 &visn, string excluded="") {
+	void change_nodes(net_collector_base *netcol, T0 &visn,
+			unsigned excluded=name_table::npos) {
 		typedef typename T0::iterator itype;
+		if (shownsizes.size()<netcol->maxstored)
+			shownsizes.resize(netcol->maxstored, -1);
 		for (itype i=visn.begin(); i!=visn.end(); i++) {
-			if (i->nm!=excluded) {
+			double size = 5*sqrt(netcol->net.get((*i).pos,(*i).pos));
+			double &shown = shownsizes[(*i).pos];
+			if (shown>=0 && !changed(shown, size)) continue;
+			if (i->id!=excluded) {
 				oc->set_attributes( "r",0.0, "g",0.2, "b",0.8,
-										  "size",5*sqrt(netcol->net[(*i).pos][(*i).pos]) );
+										  "size",size );
 			}
-			oc->change_node((*i).nm);
+			oc->change_node(name(*i));
+			shown = size;
 		}
 	}
 
@@ -195,47 +188,111 @@ protected:
 		return node_object.pos;
 	}
 
-   // sends to the output client changes in edge weights and colors
+   // sends to the output client changes in edge weights and colors, each
+   // undirected edge once; an edge is sent once it is added and then when
+   // its weight changes by more than the change tolerance
 	template <class T0, class T1, class F>
 	void change_edges(net_collector_base *netcol, T0 &visn,
 							T1 &eidm, F extractpos, double edgeminweight=0.0001,
 							double r=0.5, double g=0.5, double b=0.5) {
 		typedef typename T0::iterator itype;
-		for (itype i=visn.begin(); i!=visn.end(); i++)
-			for (itype j=visn.begin(); j!=visn.end(); j++) {
-				if (netcol->net[extractpos(*i)][extractpos(*j)]>edgeminweight)
-				if (i!=j) {
-					if (eidm[extractpos(*i)][extractpos(*j)]) {
+		mark_positions( netcol, visn, extractpos );
+		for (itype i=visn.begin(); i!=visn.end(); i++) {
+			linked_nodes( netcol, visn, i-visn.begin(), true, extractpos );
+			for (unsigned k=0; k<linked.size(); k++) {
+				itype j=visn.begin()+linked[k];
+				double weight = netcol->net.get(extractpos(*i),extractpos(*j));
+				if (weight>edgeminweight) {
+					typename T1::entry *edge = eidm.find(extractpos(*i),extractpos(*j));
+					if (edge) {
+						if (!changed(edge->weight, weight)) continue;
 						oc->set_attributes(
-							"weight",netcol->net[extractpos(*i)][extractpos(*j)],
+							"weight",weight,
 							"r",r, "g",g, "b",b );
-						oc->change_edge( eidm[extractpos(*i)][extractpos(*j)] );
+						oc->change_edge( edge->id );
+						edge->weight = weight;
 					}
 					else {
 						oc->set_attributes(
-							"source",(*i).nm,
-							"target",netcol->names[extractpos(*j)],
+							"source",name(*i),
+							"target",nodenames->c_str(netcol->ids[extractpos(*j)]),
 							"directed",false,
-							"weight",netcol->net[extractpos(*i)][extractpos(*j)],
+							"weight",weight,
 							"r",r, "g",g, "b",b );
 						oc->add_edge( eid );
-						eidm[extractpos(*i)][extractpos(*j)]=eid;
-						eidm[extractpos(*j)][extractpos(*i)]=eid;
+						eidm.set(extractpos(*i),extractpos(*j),eid,weight);
 						eid++;
 					}
 				}
 			}
+		}
+		unmark_positions( visn, extractpos );
+	}
+
+	// marks the collector positions of the nodes with their index in visn
+	template <class T0, class F>
+	void mark_positions(net_collector_base *netcol, T0 &visn, F extractpos) {
+		if (visindex.size()<netcol->maxstored)
+			visindex.resize(netcol->maxstored, -1);
+		for (unsigned i=0; i<visn.size(); i++) visindex[extractpos(visn[i])]=i;
+	}
+
+	template <class T0, class F>
+	void unmark_positions(T0 &visn, F extractpos) {
+		for (unsigned i=0; i<visn.size(); i++) visindex[extractpos(visn[i])]=-1;
+	}
+
+	// puts into linked the indices of the marked nodes linked to the node
+	// a of visn, all of them or only those after it, in the order of visn;
+	// the links of the node are visited instead of all the nodes of visn
+	// when it has fewer of them
+	template <class T0, class F>
+	void linked_nodes(net_collector_base *netcol, T0 &visn, unsigned a,
+			bool after, F extractpos) {
+		linked.clear();
+		const sparse_net::row_type &row = netcol->net.row(extractpos(visn[a]));
+		if (row.size()<visn.size()) {
+			for (sparse_net::row_type::const_iterator it=row.begin();
+					it!=row.end(); it++) {
+				int b = visindex[it->first];
+				if (b>=0 && (after ? b>(int)a : b!=(int)a)) linked.push_back(b);
+			}
+			sort( linked.begin(), linked.end() );
+		}
+		else
+			for (unsigned b=after ? a+1 : 0; b<visn.size(); b++)
+				if (b!=a) linked.push_back(b);
+	}
+
+	// the value has moved from the one sent by more than the tolerance
+	bool changed(double shown, double value) const {
+		return fabs(value-shown)>changetolerance*fabs(shown);
+	}
+
+	void forget_shown_size(unsigned pos) {
+		if (pos<shownsizes.size()) shownsizes[pos]=-1;
+	}
+
+	// resolves the name of the node when it is sent to the output client
+	template <class T0>
+	const char* name(const T0 &node_object) {
+		return nodenames->c_str(node_object.id);
 	}
 
 	client_base *oc; // output client
+	const name_table *nodenames;
 	unsigned eid;
 
 protected:
 	unsigned verbose;
+	double changetolerance; // relative change of a value that is sent
 
 private:
 	unsigned nodes_visualized, nodes_not_visualized;
 	double total_score;
+	vector <double> shownsizes; // node sizes sent for each position, or -1
+	vector <int> visindex; // index of the node at each position, or -1
+	vector <unsigned> linked;
 };
 
 
@@ -243,19 +300,26 @@ class viz_selector: public viz_selector_base {
 public:
 
 	viz_selector (net_collector_base &mynet, client_base &client,
-			clock_collectors &mycc, int verbose) :
-			eidm(mynet.maxstored, vector <unsigned long> (mynet.maxstored,0)) {
+			clock_collectors &mycc, int verbose, double changetolerance=0,
+			bool trackstats=false, bool exactcounts=false) :
+			eidm(mynet.maxstored),
+			allnodes_drawn(exactcounts && !mynet.nodenames.recycles()) {
 		netcol=&mynet;
+		nodenames=&mynet.nodenames;
 		oc=&client;
 		myclockcollector=&mycc;
 		eid=1;
 		this->verbose=verbose;
+		this->changetolerance=changetolerance;
+		// follows the links of the buffered network when its statistics
+		// are read often enough to pay for it
+		if (trackstats) buffered.reset(new net_stats_tracker(mynet.net));
 	}
 
 
    // the main method, calling all the private methods
 	void draw (const unsigned maxvisualized, double edgeminweight,
-               string excluded="", bool hide_singletons=true ) {
+               unsigned excluded=name_table::npos, bool hide_singletons=true ) {
 		if (verbose>5) cout<<"___________________________________________"<<endl;
 
 		// selects nodes from netcol, removes singletons, sorts them, and
@@ -266,11 +330,11 @@ public:
 		myclockcollector->collect("TTTTselect_nodes");
 
 		adddelete_nodes(prevvisn, vntmp, eidm,
-			clean_edgeids < vector <node_the>, vector <vector <unsigned long> > > );
+			clean_edgeids < vector <node_the>, edge_id_map > );
 		if (verbose>5) {
-			for (int i=0; i<prevvisn.size(); i++) cout<<prevvisn[i].nm<<" ";
+			for (int i=0; i<prevvisn.size(); i++) cout<<name(prevvisn[i])<<" ";
 				cout<<endl;
-			for (int i=0; i<vntmp.size(); i++) cout<<vntmp[i].nm<<" ";
+			for (int i=0; i<vntmp.size(); i++) cout<<name(vntmp[i])<<" ";
 				cout<<endl;
 			cout<<endl;
 		}
@@ -282,15 +346,17 @@ public:
 		if (verbose>4) {
 			cout<<"nodes visualized (draw): ";
 			for (vector <node_the>::iterator it=vntmp.begin(); it!=vntmp.end(); it++)
-				cout<<it->nm<<","<<it->pos<<" ";
+				cout<<name(*it)<<","<<it->pos<<" ";
 			cout<<endl;
 		}
-   	if (verbose>0) allnodes_drawn.insert( vntmp.begin(), vntmp.end() );
+		if (verbose>0)
+			for (unsigned i=0; i<vntmp.size(); i++)
+				allnodes_drawn.insert(nodenames->key(vntmp[i].id));
 		swap(prevvisn,vntmp);
 		myclockcollector->collect("TTTTupdate_nodes_edges");
 
 		// print the differential update to the file
-		if (maxvisualized<100) oc->update();
+		oc->update();
 
 		myclockcollector->collect("TTTTgcupdate");
 
@@ -298,25 +364,23 @@ public:
 
    // get networks statistics
  	void get_netsstats(char *output) {
-		netstats ns_buf, ns_viz;
-		igraph_t g;
-		igraph_vector_t weights;
-
-		// get the visualized graph and its properties
-		vector <vector <double> > viznet;
-		get_visualized_net( viznet );
-		igraph_vector_init(&weights, 0);
-		vv_to_igraph(viznet, g, weights);
-		ns_viz = get_netstats(g, weights);
-		igraph_vector_destroy(&weights);
-		igraph_destroy(&g);
-
-		// get the buffered graph and its properties
-		igraph_vector_init(&weights, 0);
-		vv_to_igraph(netcol->net, g, weights);
-		ns_buf = get_netstats(g, weights);
-		igraph_vector_destroy(&weights);
-		igraph_destroy(&g);
+		// the visualized graph and its properties
+		vector <unsigned> nodes;
+		for (int i=0; i<prevvisn.size(); i++) nodes.push_back(prevvisn[i].pos);
+		if (verbose>3) print_visualized_net();
+		netstats ns_viz = net_stats(netcol->net, nodes).compute();
+
+		// the buffered graph and its properties; the nodes are counted in
+		// the buffer, not by the collector
+		netstats ns_buf;
+		if (buffered)
+			ns_buf = buffered->get(netcol->net_collector_base::get_nodes_number());
+		else {
+			nodes.clear();
+			for (unsigned i=0; i<netcol->ids.size(); i++)
+				if (netcol->ids[i]!=name_table::npos) nodes.push_back(i);
+			ns_buf = net_stats(netcol->net, nodes).compute();
+		}
 
 		sprintf( output,
             "avgdeg_buffered=%9.2f, avgdeg_visualized=%9.2f, "
@@ -336,128 +400,44 @@ public:
 
    void print_visualized_nodes(ofstream &ostream){
 		for (auto it=prevvisn.begin(); it!=prevvisn.end(); it++)
-			ostream<<it->nm<<" ";
+			ostream<<name(*it)<<" ";
 		ostream<<endl;
 
       // debug
       // ostream.precision(2);
       // for (auto it=prevvisn.begin(); it!=prevvisn.end(); it++)
-      //    ostream<<it->nm<<" "<<it->str<<" | ";
+      //    ostream<<name(*it)<<" "<<it->str<<" | ";
       // ostream<<endl;
    }
 
 private:
 
-	// get the visualized graph and its properties
-   void get_visualized_net( vector <vector <double> > &viznet ) {
-		// vector<unsigned> nodesdrawn;
-		// for (vector <node_the>::iterator it=prevvisn.begin();
-		// 	it!=prevvisn.end(); it++) nodesdrawn.push_back( it->pos );
-		// if (verbose>4) {
-		// 	cout<<"nodes visualized (get_netsstats): ";
-		// 	for (vector <node_the>::iterator it=prevvisn.begin();
-		// 		it!=prevvisn.end(); it++) cout<<it->nm<<","<<it->pos<<" ";
-		// 	cout<<endl;
-		// }
-
-		for (int i=0; i<prevvisn.size(); i++) {
-			vector <double> curnode;
-			for (int j=0; j<prevvisn.size(); j++)
-				curnode.push_back( netcol->net[prevvisn[i].pos][prevvisn[j].pos] );
-			viznet.push_back( curnode );
-		}
-
-      if (verbose>3) {
-         cout<<"viznet network (full):"<<endl;
-         for (int i=0; i<viznet.size(); i++) cout<<prevvisn[i].nm<<" ";
+	// prints the weights between the visualized nodes
+   void print_visualized_net() {
+      cout<<"viznet network (full):"<<endl;
+      for (int i=0; i<prevvisn.size(); i++) cout<<name(prevvisn[i])<<" ";
+      cout<<endl;
+      for (int i=0; i<prevvisn.size(); i++) {
+         for (int j=0; j<prevvisn.size(); j++)
+            cout<<netcol->net.get(prevvisn[i].pos,prevvisn[j].pos)<<" ";
          cout<<endl;
-         for (int i=0; i<viznet.size(); i++) {
-            for (int j=0; j<viznet.size(); j++)
-               cout<<viznet[i][j]<<" ";
-            cout<<endl;
-         }
       }
    }
 
-   struct netstats {
-   	netstats() {};
-   	netstats( double avgdeg, double avgstr, double ccglo, double ccloc,
-   			double assdeg, double assstr ){
-   		this->avgdeg = avgdeg;
-   		this->avgstr = avgstr;
-   		this->ccglo = ccglo;
-   		this->ccloc = ccloc;
-   		this->assdeg = assdeg;
-   		this->assstr = assstr;
-   	}
-   	double avgdeg, avgstr, ccglo, ccloc, assdeg, assstr;
- 	   netstats& operator=(const netstats &other) {
-   		this->avgdeg = other.avgdeg;
-   		this->avgstr = other.avgstr;
-   		this->ccglo = other.ccglo;
-   		this->ccloc = other.ccloc;
-   		this->assdeg = other.assdeg;
-   		this->assstr = other.assstr;
-   	}
-   };
-
-   // get networks statistics
- 	netstats get_netstats( igraph_t &g, igraph_vector_t &weights ) {
-
-		// get degree
-		igraph_real_t avgdeg;
-		igraph_vector_t degrees;
-		igraph_vector_init(&degrees, 0);
-      igraph_bool_t loops = false;
-		igraph_degree( &g, &degrees, igraph_vss_all(), IGRAPH_ALL, loops);
-		for (int i=0; i<igraph_vector_size(&degrees); i++)
-			avgdeg+=VECTOR(degrees)[i];
-		cout<<"degree: "<<avgdeg<<" "<<igraph_vector_size(&degrees)<<endl;
-		avgdeg /= 1.0*igraph_vector_size(&degrees);
-
-		// get strength
-		igraph_real_t avgstr;
-		igraph_vector_t strengths;
-		igraph_vector_init(&strengths, 0);
-		igraph_strength( &g, &strengths, igraph_vss_all(), IGRAPH_ALL, loops, &weights);
-		for (int i=0; i<igraph_vector_size(&strengths); i++)
-			avgstr+=VECTOR(strengths)[i];
-		avgstr /= 1.0*igraph_vector_size(&strengths);
-
-		// get cc
-		igraph_real_t ccglo;
-		igraph_transitivity_undirected( &g, &ccglo,
-			IGRAPH_TRANSITIVITY_ZERO );
-		igraph_real_t ccloc;
-		igraph_transitivity_avglocal_undirected( &g, &ccloc,
-			IGRAPH_TRANSITIVITY_ZERO );
-
-		// get assortativity
-		igraph_real_t assdeg, assstr;
-      igraph_bool_t directed = false;
-		igraph_assortativity_nominal( &g, &degrees, &assdeg, directed );
-		igraph_assortativity_nominal( &g, &strengths, &assstr, directed );
-
-		igraph_vector_destroy(&degrees);
-		igraph_vector_destroy(&strengths);
-
-		netstats output( (double)avgdeg, (double)avgstr, (double)ccglo,
-							  (double)ccloc, (double)assdeg, (double)assstr );
-		return output;
-   }
-
    // get aggregated statistics
-   long get_how_many_drawn() { return allnodes_drawn.size(); }
+   long get_how_many_drawn() { return allnodes_drawn.count(); }
 
 private:
 	net_collector_base *netcol;
 
    // main containers
 	vector <node_the> prevvisn;
-	vector <vector <unsigned long> > eidm;
+	edge_id_map eidm; // ids of the visualized edges
+	// statistics of the buffered network
+	unique_ptr <net_stats_tracker> buffered;
 
    // used only for the purpose of aggregated statistics
-   set <node_the> allnodes_drawn;
+   distinct_counter allnodes_drawn;
 
 	clock_collectors *myclockcollector;
 };
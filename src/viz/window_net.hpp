@@ -0,0 +1,112 @@
+/*
+ * Aggregated graph of all the links present in a time-window, indexed by
+ * the ids of the node names. Node strengths and pair weights are updated
+ * link by link as the links enter and leave the window.
+ */
+
+#ifndef VIZ_WINDOW_NET_HPP
+#define VIZ_WINDOW_NET_HPP
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class window_net {
+public:
+
+   struct pair_type {
+      double weight;
+      unsigned links; // number of links of the pair in the window
+   };
+   typedef unordered_map <unsigned, pair_type> row_type;
+
+   window_net () :nodes_number(0) {}
+
+   // number of ids the net can hold, grows with the largest id added
+   unsigned size() const { return strengths.size(); }
+
+   // number of nodes having at least one link in the window
+   unsigned get_nodes_number() const { return nodes_number; }
+
+   double strength (unsigned id) const { return strengths[id]; }
+   unsigned links (unsigned id) const { return nlinks[id]; }
+   const row_type& row (unsigned id) const { return rows[id]; }
+
+   double get (unsigned id1, unsigned id2) const {
+      row_type::const_iterator found = rows[id1].find(id2);
+      if (found==rows[id1].end()) return 0;
+      return found->second.weight;
+   }
+
+   void add_link (unsigned id1, unsigned id2, double weight) {
+      if (id1>=size() || id2>=size()) resize( max(id1,id2)+1 );
+      add_to_node(id1, weight);
+      add_to_node(id2, weight);
+      add_to_pair(id1, id2, weight);
+      add_to_pair(id2, id1, weight);
+   }
+
+   void remove_link (unsigned id1, unsigned id2, double weight) {
+      remove_from_node(id1, weight);
+      remove_from_node(id2, weight);
+      remove_from_pair(id1, id2, weight);
+      remove_from_pair(id2, id1, weight);
+   }
+
+   // frees the row of a node without links
+   void forget (unsigned id) {
+      row_type().swap(rows[id]);
+   }
+
+   void scale (double factor) {
+      for (unsigned i=0; i<rows.size(); i++) if (nlinks[i]) {
+         strengths[i] *= factor;
+         for (row_type::iterator it=rows[i].begin(); it!=rows[i].end(); it++)
+            it->second.weight *= factor;
+      }
+   }
+
+private:
+
+   void resize (unsigned newsize) {
+      strengths.resize(newsize, 0);
+      nlinks.resize(newsize, 0);
+      rows.resize(newsize);
+   }
+
+   void add_to_node (unsigned id, double weight) {
+      if (nlinks[id]++==0) nodes_number++;
+      strengths[id] += weight;
+   }
+
+   // a node without links gets exactly zero strength, so that rounding
+   // errors of the subtractions do not accumulate
+   void remove_from_node (unsigned id, double weight) {
+      if (--nlinks[id]==0) {
+         nodes_number--;
+         strengths[id] = 0;
+      }
+      else strengths[id] -= weight;
+   }
+
+   void add_to_pair (unsigned id1, unsigned id2, double weight) {
+      pair_type &p = rows[id1][id2];
+      p.weight += weight;
+      p.links++;
+   }
+
+   void remove_from_pair (unsigned id1, unsigned id2, double weight) {
+      row_type::iterator found = rows[id1].find(id2);
+      if (--found->second.links==0) rows[id1].erase(found);
+      else found->second.weight -= weight;
+   }
+
+   vector <double> strengths;
+   vector <unsigned> nlinks;
+   vector <row_type> rows;
+   unsigned nodes_number;
+};
+
+#endif